@@ -0,0 +1,389 @@
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <linux/input.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <string.h>
+#include <pthread.h>
+#include "./device.h"
+
+#define DEV_FD_MAX 64		// file descriptors tracked by backend
+#define SHADOW_MAX 32		// largest display write (text lcd)
+#define REPLAY_MAX 4096		// records of one replay
+#define REPLAY_EVENTS (4 * REPLAY_MAX)	// input events of 'e' records of one replay
+#define RECORD_EVENTS 32	// input events of one 'e' record (one read)
+#define REPLAY_QUIT 1000000	// quit this long after last record (us)
+#define REPLAY_STACK (64 * 1024)	// replayer stack (memory may be locked)
+
+#define SW_QUIT 116
+
+// one recorded input
+struct record{
+	long long time;		// since start (us)
+	char type;		// 'e' event key read, 'k' event key, 's' push switch
+	int code;		// key code / switch bit mask / events of read
+	int value;		// key press or release
+	int first;		// first event of read in replay_ev
+};
+
+// state shared by every role (process or thread)
+struct dev_state{
+	long long start;		// time of dev_init (us)
+	volatile long long event_time;	// last input not yet displayed
+	volatile unsigned int push_sw;	// simulated switch (bit per switch)
+	unsigned int count[DEV_MODES];
+	unsigned int hist[DEV_MODES][LATENCY_SLOT];
+};
+
+// last value shown on a display
+struct shadow{
+	int len;
+	unsigned char data[SHADOW_MAX];
+};
+
+extern char *mode_shm;		// current mode of main.c
+
+static struct dev_state *state;
+static int simulated;		// replaying, no real device is touched
+static int record_fd = -1;
+static int event_pipe[2];	// simulated event key
+
+static struct record *replay;
+static int replay_len, replay_speed;
+static struct input_event *replay_ev;	// events of 'e' records
+static int replay_ev_len;
+static pthread_t replay_thread;
+
+// per process (only the role owning a device uses it)
+static enum dev_kind fd_kind[DEV_FD_MAX];
+static const char *fd_name[DEV_FD_MAX + DEV_KINDS];
+static unsigned int last_push_sw;
+static struct shadow shadow[DEV_FD_MAX + DEV_KINDS];
+
+static long long dev_now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// append one input to record file (single write, safe between roles)
+static void dev_record(char type, int code, int value){
+	char line[64];
+	int len;
+
+	if(record_fd < 0)
+		return;
+
+	len = sprintf(line, "%lld %c %d %d\n", dev_now() - state->start, type, code, value);
+	write(record_fd, line, len);
+}
+
+// append one read of event key as is, SYN events included
+// ("time e count type code value ...", a long read takes several records)
+static void dev_record_events(const struct input_event *ev, int count){
+	char line[32 + RECORD_EVENTS * 36];
+	long long now;
+	int i, n, len;
+
+	if(record_fd < 0)
+		return;
+
+	now = dev_now() - state->start;
+	for(;count>0;ev+=n,count-=n){
+		n = count < RECORD_EVENTS ? count : RECORD_EVENTS;
+		len = sprintf(line, "%lld e %d", now, n);
+		for(i=0;i<n;i++)
+			len += sprintf(line + len, " %d %d %d", ev[i].type, ev[i].code, ev[i].value);
+		line[len++] = '\n';
+		write(record_fd, line, len);
+	}
+}
+
+// print changed display of simulated board, one write per line
+// (roles print concurrently, replay tests match these lines)
+static void dev_print(int id, const unsigned char *data, int len){
+	char line[32 + 4 * SHADOW_MAX + 8];
+	int i, n;
+
+	n = sprintf(line, "SIM: %.24s \"", fd_name[id] ? fd_name[id] : "?");
+	for(i=0;i<len;i++){
+		if(data[i] >= 0x20 && data[i] < 0x7f && data[i] != '"' && data[i] != '\\')
+			line[n++] = data[i];
+		else
+			n += sprintf(line + n, "\\x%02x", data[i]);
+	}
+	n += sprintf(line + n, "\"\n");
+	write(STDOUT_FILENO, line, n);
+}
+
+// input observed, display change after it is the latency to measure
+static void dev_event(void){
+	state->event_time = dev_now();
+}
+
+// display changed, account latency of pending input to current mode
+static void dev_display(int id, const void *data, int len, char mode){
+	struct shadow *s = &shadow[id];
+	long long event_time;
+	int slot;
+
+	if(len > SHADOW_MAX)
+		len = SHADOW_MAX;
+	if(s->len == len && memcmp(s->data, data, len) == 0)
+		return;
+	s->len = len;
+	memcpy(s->data, data, len);
+	if(simulated)
+		dev_print(id, s->data, len);
+
+	event_time = state->event_time;
+	if(event_time == 0 || mode < '1' || mode > '0' + DEV_MODES)
+		return;
+	state->event_time = 0;
+
+	slot = (dev_now() - event_time) / 1000;
+	if(slot >= LATENCY_SLOT)
+		slot = LATENCY_SLOT - 1;
+	state->hist[mode - '1'][slot]++;
+	state->count[mode - '1']++;
+}
+
+// load records of replay file
+static int dev_load(const char *path){
+	FILE *fp;
+	struct record r;
+	struct input_event *ev;
+	int i, type, code, value;
+
+	if((fp = fopen(path, "r")) == NULL)
+		return -1;
+
+	replay = malloc(sizeof(struct record) * REPLAY_MAX);
+	replay_ev = calloc(REPLAY_EVENTS, sizeof(struct input_event));
+	if(replay == NULL || replay_ev == NULL){
+		fclose(fp);
+		return -1;
+	}
+
+	// records end at first one not complete
+	while(replay_len < REPLAY_MAX && fscanf(fp, "%lld %c %d", &r.time, &r.type, &r.code) == 3){
+		if(r.type != 'e'){
+			if(fscanf(fp, "%d", &r.value) != 1)
+				break;
+			replay[replay_len++] = r;
+			continue;
+		}
+
+		if(r.code < 1 || r.code > RECORD_EVENTS || replay_ev_len + r.code > REPLAY_EVENTS)
+			break;
+		r.first = replay_ev_len;
+		for(i=0;i<r.code;i++){
+			if(fscanf(fp, "%d %d %d", &type, &code, &value) != 3)
+				break;
+			ev = &replay_ev[r.first + i];
+			ev->type = type;
+			ev->code = code;
+			ev->value = value;
+		}
+		if(i < r.code)
+			break;
+		replay_ev_len += r.code;
+		replay[replay_len++] = r;
+	}
+	fclose(fp);
+
+	return 0;
+}
+
+static void dev_key(int code, int value){
+	struct input_event ev[2];
+
+	memset(ev, 0, sizeof(ev));
+	ev[0].type = EV_KEY;
+	ev[0].code = code;
+	ev[0].value = value;
+	ev[1].type = EV_SYN;
+	ev[1].code = SYN_REPORT;
+
+	// one frame per write, pipe keeps it atomic
+	write(event_pipe[1], ev, sizeof(ev));
+}
+
+// events of one recorded read in one write, a waiting reader gets them
+// in one read (burst), a frame split over records is split over reads
+static void dev_events(const struct record *r){
+	write(event_pipe[1], &replay_ev[r->first], r->code * sizeof(struct input_event));
+}
+
+// feed records at original time divided by speed
+static void *dev_replayer(void *arg){
+	struct timespec ts;
+	long long start = dev_now(), at;
+	int i;
+
+	for(i=0;i<=replay_len;i++){
+		if(i < replay_len)
+			at = start + replay[i].time / replay_speed;
+		else
+			at = start + (replay_len ? replay[i-1].time / replay_speed : 0) + REPLAY_QUIT;
+
+		ts.tv_sec = at / 1000000;
+		ts.tv_nsec = at % 1000000 * 1000;
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+
+		// recording may lack quit, end program after last record
+		if(i == replay_len){
+			dev_key(SW_QUIT, 1);
+			dev_key(SW_QUIT, 0);
+			break;
+		}
+
+		dev_event();
+		if(replay[i].type == 'e')
+			dev_events(&replay[i]);
+		else if(replay[i].type == 'k')
+			dev_key(replay[i].code, replay[i].value);
+		else if(replay[i].type == 's')
+			state->push_sw = replay[i].code;
+	}
+
+	printf("DEBUG: replay of %d records done\n", replay_len);
+	return NULL;
+}
+
+int dev_init(const char *record, const char *replay_path, int speed){
+	// shared between roles forked after this
+	state = mmap(NULL, sizeof(struct dev_state), PROT_READ|PROT_WRITE,
+			MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+	if(state == MAP_FAILED)
+		return -1;
+	memset(state, 0, sizeof(struct dev_state));
+	state->start = dev_now();
+
+	if(record != NULL)
+		if((record_fd = open(record, O_WRONLY|O_CREAT|O_TRUNC|O_APPEND, 0644)) < 0)
+			return -1;
+
+	if(replay_path != NULL){
+		if(dev_load(replay_path) < 0 || pipe(event_pipe) < 0)
+			return -1;
+		replay_speed = speed < 1 ? 1 : speed;
+		simulated = 1;
+		fd_name[DEV_FD_MAX + DEV_GPIO_FND] = "gpio_fnd";
+	}
+
+	return 0;
+}
+
+void dev_replay(void){
+	pthread_attr_t attr;
+
+	if(!simulated)
+		return;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, REPLAY_STACK);
+	pthread_create(&replay_thread, &attr, dev_replayer, NULL);
+	pthread_attr_destroy(&attr);
+}
+
+int dev_open(const char *path, int flags){
+	enum dev_kind kind = DEV_OTHER;
+	int fd;
+
+	if(strcmp(path, "/dev/input/event1") == 0)
+		kind = DEV_EVENT_KEY;
+	else if(strcmp(path, "/dev/fpga_push_switch") == 0)
+		kind = DEV_PUSH_SWITCH;
+	else if(strcmp(path, "/dev/mem") == 0)
+		kind = DEV_MEM;
+
+	if(!simulated)
+		fd = open(path, flags);
+	else if(kind == DEV_EVENT_KEY)
+		fd = dup(event_pipe[0]);
+	else
+		fd = open("/dev/null", O_RDWR);
+
+	if(fd >= 0 && fd < DEV_FD_MAX){
+		fd_kind[fd] = kind;
+		fd_name[fd] = path;
+		shadow[fd].len = -1;
+	}
+
+	return fd;
+}
+
+void *dev_mmap(int fd, off_t offset){
+	// registers of simulated board are plain memory
+	if(simulated)
+		return mmap(NULL, 4096, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+	return mmap(NULL, 4096, PROT_READ|PROT_WRITE, MAP_SHARED, fd, offset);
+}
+
+ssize_t dev_read(int fd, void *buf, size_t count){
+	enum dev_kind kind = (fd >= 0 && fd < DEV_FD_MAX) ? fd_kind[fd] : DEV_OTHER;
+	struct input_event *ev = buf;
+	unsigned char *push_sw = buf;
+	unsigned int mask = 0;
+	ssize_t rd;
+	int i;
+
+	// simulated switch state set by replayer
+	if(simulated && kind == DEV_PUSH_SWITCH){
+		mask = state->push_sw;
+		for(i=0;i<count;i++)
+			push_sw[i] = (mask >> i) & 1;
+		return count;
+	}
+
+	if((rd = read(fd, buf, count)) <= 0)
+		return rd;
+
+	if(kind == DEV_EVENT_KEY){
+		dev_record_events(ev, rd / sizeof(struct input_event));
+		for(i=0;i<rd/sizeof(struct input_event) && !simulated;i++)
+			if(ev[i].type == EV_KEY){
+				dev_event();
+				break;
+			}
+	}
+
+	else if(kind == DEV_PUSH_SWITCH){
+		for(i=0;i<rd;i++)
+			if(push_sw[i] == 1)
+				mask |= 1 << i;
+		if(mask != last_push_sw){
+			last_push_sw = mask;
+			dev_record('s', mask, 0);
+			if(!simulated)
+				dev_event();
+		}
+	}
+
+	return rd;
+}
+
+ssize_t dev_write(int fd, const void *buf, size_t count){
+	if(fd >= 0 && fd < DEV_FD_MAX)
+		dev_display(fd, buf, count, *mode_shm);
+
+	return write(fd, buf, count);
+}
+
+void dev_shown(enum dev_kind kind, const void *data, int len){
+	dev_display(DEV_FD_MAX + kind, data, len, *mode_shm);
+}
+
+unsigned int *dev_latency(char mode, unsigned int *count){
+	*count = state->count[mode - '1'];
+	return state->hist[mode - '1'];
+}
@@ -0,0 +1,42 @@
+/* Device backend of 20091648
+   every device access of the roles goes through here, so input can be
+   recorded, replayed from simulated devices and event-to-display latency
+   measured per mode (displays of simulated devices are printed as "SIM:"
+   lines, see replay target of Makefile) */
+
+#ifndef __DEVICE_H__
+#define __DEVICE_H__
+
+#include <sys/types.h>
+
+#define LATENCY_SLOT 128	// latency histograms (1ms per slot)
+#define DEV_MODES 3		// stop watch, text editor, custom
+
+// kind of device opened by dev_open
+enum dev_kind{
+	DEV_OTHER,
+	DEV_EVENT_KEY,		// /dev/input/event1
+	DEV_PUSH_SWITCH,	// /dev/fpga_push_switch
+	DEV_MEM,		// /dev/mem (gpio registers)
+	DEV_GPIO_FND,		// fnd digits multiplexed from registers
+	DEV_KINDS
+};
+
+// set up backend before roles start (record / replay may be NULL, speed >= 1)
+int dev_init(const char *record, const char *replay, int speed);
+
+// start feeding replayed input (after roles started)
+void dev_replay(void);
+
+int dev_open(const char *path, int flags);
+void *dev_mmap(int fd, off_t offset);
+ssize_t dev_read(int fd, void *buf, size_t count);
+ssize_t dev_write(int fd, const void *buf, size_t count);
+
+// display changed without dev_write (registers written directly)
+void dev_shown(enum dev_kind kind, const void *data, int len);
+
+// event-to-display histogram of a mode ('1' ~ '3')
+unsigned int *dev_latency(char mode, unsigned int *count);
+
+#endif
@@ -0,0 +1,163 @@
+/* Dot matrix animations, generated by dotanim from dot_anim.txt
+   do not edit, change the script and run make */
+
+#ifndef __DOT_ANIM__
+#define __DOT_ANIM__
+
+#define DOT_ANIM_FRAMES 139
+
+#define DOT_ANIM_HELPME 0
+#define DOT_ANIMS 1
+
+// first frame and number of frames of each animation
+static const struct dot_anim{
+	const char *name;
+	int first;
+	int count;
+} dot_anims[DOT_ANIMS] = {
+	{"helpme", 0, 139},
+};
+
+static const unsigned char dot_frames[DOT_ANIM_FRAMES][10] = {
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x47,0x47,0x47,0x47,0x7f,0x7f,0x47,0x47,0x47,0x47},
+	{0x0f,0x0f,0x0f,0x0f,0x7f,0x7f,0x0f,0x0f,0x0f,0x0f},
+	{0x1f,0x1f,0x1e,0x1e,0x7f,0x7f,0x1e,0x1e,0x1f,0x1f},
+	{0x3f,0x3f,0x3c,0x3c,0x7f,0x7f,0x3c,0x3c,0x3f,0x3f},
+	{0x7f,0x7f,0x78,0x78,0x7f,0x7f,0x78,0x78,0x7f,0x7f},
+	{0x7f,0x7f,0x70,0x70,0x7f,0x7f,0x70,0x70,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x41,0x41,0x7f,0x7f,0x41,0x41,0x7f,0x7f},
+	{0x7f,0x7f,0x03,0x03,0x7f,0x7f,0x03,0x03,0x7f,0x7f},
+	{0x7e,0x7e,0x06,0x06,0x7e,0x7e,0x06,0x06,0x7f,0x7f},
+	{0x7c,0x7c,0x0c,0x0c,0x7c,0x7c,0x0c,0x0c,0x7f,0x7f},
+	{0x78,0x78,0x18,0x18,0x78,0x78,0x18,0x18,0x7f,0x7f},
+	{0x70,0x70,0x30,0x30,0x70,0x70,0x30,0x30,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x41,0x41,0x41,0x41,0x41,0x41,0x41,0x41,0x7f,0x7f},
+	{0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x7f,0x7f},
+	{0x07,0x07,0x06,0x06,0x07,0x07,0x06,0x06,0x7e,0x7e},
+	{0x0f,0x0f,0x0c,0x0c,0x0f,0x0f,0x0c,0x0c,0x7c,0x7c},
+	{0x1f,0x1f,0x18,0x18,0x1f,0x1f,0x18,0x18,0x78,0x78},
+	{0x3f,0x3f,0x31,0x31,0x3f,0x3f,0x30,0x30,0x70,0x70},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7d,0x7f,0x47,0x47,0x7f,0x7d,0x41,0x41,0x41,0x41},
+	{0x7b,0x7f,0x0f,0x0f,0x7f,0x7b,0x03,0x03,0x03,0x03},
+	{0x76,0x7f,0x1f,0x1f,0x7e,0x76,0x06,0x06,0x06,0x06},
+	{0x6c,0x7e,0x3f,0x3f,0x7d,0x6c,0x0c,0x0c,0x0c,0x0c},
+	{0x58,0x7d,0x7f,0x7f,0x7a,0x58,0x18,0x18,0x18,0x18},
+	{0x31,0x7b,0x7f,0x7f,0x75,0x31,0x31,0x31,0x31,0x31},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x47,0x6f,0x7f,0x7f,0x57,0x47,0x47,0x47,0x47,0x47},
+	{0x0f,0x5f,0x7f,0x7f,0x2f,0x0f,0x0f,0x0f,0x0f,0x0f},
+	{0x1f,0x3f,0x7e,0x7e,0x5f,0x1f,0x1e,0x1e,0x1f,0x1f},
+	{0x3f,0x7f,0x7c,0x7c,0x3f,0x3f,0x3c,0x3c,0x3f,0x3f},
+	{0x7f,0x7f,0x78,0x78,0x7f,0x7f,0x78,0x78,0x7f,0x7f},
+	{0x7f,0x7f,0x70,0x70,0x7f,0x7f,0x70,0x70,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7e,0x7e,0x40,0x40,0x7e,0x7e,0x40,0x40,0x7e,0x7e},
+	{0x7c,0x7c,0x00,0x00,0x7c,0x7c,0x00,0x00,0x7c,0x7c},
+	{0x78,0x78,0x00,0x00,0x78,0x78,0x00,0x00,0x78,0x78},
+	{0x71,0x71,0x01,0x01,0x71,0x71,0x00,0x00,0x71,0x71},
+	{0x63,0x63,0x03,0x03,0x63,0x63,0x00,0x00,0x63,0x63},
+	{0x46,0x46,0x06,0x06,0x46,0x46,0x00,0x00,0x46,0x46},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x00,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x00,0x77,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x00,0x77,0x22,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x00,0x77,0x22,0x00,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x00,0x77,0x22,0x00,0x08,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x00,0x0c,0x0c},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x00,0x0c,0x0c},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x0c,0x0c},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x0c},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x01,0x6f,0x45,0x01,0x11,0x11,0x01,0x39,0x45,0x03},
+	{0x03,0x5f,0x0b,0x03,0x23,0x23,0x03,0x73,0x0b,0x07},
+	{0x06,0x3e,0x16,0x06,0x47,0x47,0x06,0x66,0x16,0x0e},
+	{0x0c,0x7c,0x2c,0x0c,0x0f,0x0f,0x0c,0x4c,0x2c,0x1c},
+	{0x18,0x78,0x58,0x18,0x1f,0x1f,0x18,0x18,0x58,0x38},
+	{0x31,0x71,0x31,0x31,0x3f,0x3f,0x31,0x31,0x31,0x71},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+};
+
+#endif
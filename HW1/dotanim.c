@@ -0,0 +1,256 @@
+/* Dot matrix animation compiler (runs on build host)
+   dotanim dot_anim.txt dot_anim.h
+
+   script :
+	font <path>		glyphs of dot font source (font/dot_font.txt) as
+				sprites named by character ('H', '!', "space")
+				or by name of control code glyph ("frown")
+	sprite <name>		10 rows of 7 columns ('#' on, '.' off), then "end"
+	anim <name>		start of animation, frames follow until "end"
+	show <sprite> <n>	sprite for n frames
+	scroll <from> <to>	7 frames, <to> pushes <from> out to the left
+	wipe <from> <to>	10 frames, <to> replaces <from> row by row from top
+   lines starting with '#' outside of sprite are comments */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DOT_ROWS 10
+#define DOT_COLS 7
+#define SPRITE_MAX 64
+#define ANIM_MAX 32
+#define FRAME_MAX 4096
+#define NAME_LEN 32
+#define LINE_BUFF 256
+
+struct sprite{
+	char name[NAME_LEN];
+	unsigned char row[DOT_ROWS];
+};
+
+struct anim{
+	char name[NAME_LEN];
+	int first;
+	int count;
+};
+
+static struct sprite sprites[SPRITE_MAX];
+static int sprite_count;
+static struct anim anims[ANIM_MAX];
+static int anim_count;
+static unsigned char frames[FRAME_MAX][DOT_ROWS];
+static int frame_count;
+static const char *path;
+static int line_no;
+
+static void fail(const char *msg, const char *arg){
+	fprintf(stderr, "%s:%d: %s %s\n", path, line_no, msg, arg ? arg : "");
+	exit(1);
+}
+
+static struct sprite *find_sprite(const char *name){
+	int i;
+
+	for(i=0;i<sprite_count;i++)
+		if(strcmp(sprites[i].name, name) == 0)
+			return &sprites[i];
+	fail("unknown sprite", name);
+	return NULL;
+}
+
+static unsigned char *new_frame(void){
+	if(frame_count == FRAME_MAX)
+		fail("too many frames", NULL);
+	return frames[frame_count++];
+}
+
+static void read_sprite(FILE *fp, const char *name){
+	struct sprite *s;
+	char line[LINE_BUFF];
+	int r, c;
+
+	if(sprite_count == SPRITE_MAX)
+		fail("too many sprites", name);
+	s = &sprites[sprite_count++];
+	strcpy(s->name, name);
+
+	for(r=0;r<DOT_ROWS;r++){
+		if(fgets(line, sizeof(line), fp) == NULL)
+			fail("sprite too short", name);
+		line_no++;
+		if(strlen(line) < DOT_COLS)
+			fail("row too short", name);
+
+		// leftmost column is bit 6
+		s->row[r] = 0;
+		for(c=0;c<DOT_COLS;c++)
+			if(line[c] == '#')
+				s->row[r] |= 1 << (DOT_COLS - 1 - c);
+	}
+
+	if(fgets(line, sizeof(line), fp) == NULL || strncmp(line, "end", 3) != 0)
+		fail("sprite without end", name);
+	line_no++;
+}
+
+// every glyph of a text font source becomes a sprite
+static void read_font(const char *font){
+	FILE *fp;
+	const char *script = path;
+	char line[LINE_BUFF], name[NAME_LEN], code[NAME_LEN];
+	int script_line = line_no;
+
+	if((fp = fopen(font, "r")) == NULL)
+		fail("cannot open font", font);
+	path = font;
+	line_no = 0;
+
+	while(fgets(line, sizeof(line), fp) != NULL){
+		line_no++;
+		if(strncmp(line, "glyph", 5) != 0)
+			continue;
+
+		// glyph '<char>' or glyph <code> <name>
+		if(sscanf(line, "glyph '%c'", name) == 1){
+			if(name[0] == ' ')
+				strcpy(name, "space");
+			else
+				name[1] = '\0';
+		}
+		else if(sscanf(line, "glyph %31s %31s", code, name) != 2)
+			fail("bad glyph", line);
+		read_sprite(fp, name);
+	}
+	fclose(fp);
+
+	path = script;
+	line_no = script_line;
+}
+
+static void emit_show(const char *name, int n){
+	struct sprite *s = find_sprite(name);
+
+	while(n-- > 0)
+		memcpy(new_frame(), s->row, DOT_ROWS);
+}
+
+static void emit_scroll(const char *from, const char *to){
+	struct sprite *a = find_sprite(from), *b = find_sprite(to);
+	unsigned char *f;
+	int k, r;
+
+	for(k=1;k<=DOT_COLS;k++){
+		f = new_frame();
+		for(r=0;r<DOT_ROWS;r++)
+			f[r] = ((a->row[r] << k) | (b->row[r] >> (DOT_COLS - k))) & 0x7f;
+	}
+}
+
+static void emit_wipe(const char *from, const char *to){
+	struct sprite *a = find_sprite(from), *b = find_sprite(to);
+	unsigned char *f;
+	int k, r;
+
+	for(k=1;k<=DOT_ROWS;k++){
+		f = new_frame();
+		for(r=0;r<DOT_ROWS;r++)
+			f[r] = (r < k) ? b->row[r] : a->row[r];
+	}
+}
+
+static void upper(char *dst, const char *src){
+	while(*src){
+		*dst++ = (*src >= 'a' && *src <= 'z') ? *src - 'a' + 'A' : *src;
+		src++;
+	}
+	*dst = '\0';
+}
+
+int main(int argc, char *argv[]){
+	FILE *in, *out;
+	char line[LINE_BUFF], cmd[NAME_LEN], a[NAME_LEN], b[NAME_LEN], name[NAME_LEN];
+	struct anim *cur = NULL;
+	int i, r, n;
+
+	if(argc != 3){
+		printf("usage: %s dot_anim.txt dot_anim.h\n", argv[0]);
+		return 1;
+	}
+
+	if((in = fopen(argv[1], "r")) == NULL){
+		perror(argv[1]);
+		return 1;
+	}
+	path = argv[1];
+
+	while(fgets(line, sizeof(line), in) != NULL){
+		line_no++;
+		if(line[0] == '#' || (n = sscanf(line, "%31s %31s %31s", cmd, a, b)) < 1)
+			continue;
+
+		if(strcmp(cmd, "font") == 0 && n == 2)
+			read_font(a);
+		else if(strcmp(cmd, "sprite") == 0 && n == 2)
+			read_sprite(in, a);
+		else if(strcmp(cmd, "anim") == 0 && n == 2){
+			if(anim_count == ANIM_MAX)
+				fail("too many animations", a);
+			cur = &anims[anim_count++];
+			strcpy(cur->name, a);
+			cur->first = frame_count;
+		}
+		else if(strcmp(cmd, "end") == 0 && cur != NULL){
+			cur->count = frame_count - cur->first;
+			cur = NULL;
+		}
+		else if(cur == NULL)
+			fail("frame outside of anim", cmd);
+		else if(strcmp(cmd, "show") == 0 && n == 3)
+			emit_show(a, atoi(b));
+		else if(strcmp(cmd, "scroll") == 0 && n == 3)
+			emit_scroll(a, b);
+		else if(strcmp(cmd, "wipe") == 0 && n == 3)
+			emit_wipe(a, b);
+		else
+			fail("bad command", cmd);
+	}
+	fclose(in);
+
+	if(cur != NULL)
+		fail("anim without end", cur->name);
+
+	if((out = fopen(argv[2], "w")) == NULL){
+		perror(argv[2]);
+		return 1;
+	}
+
+	fprintf(out, "/* Dot matrix animations, generated by dotanim from %s\n", argv[1]);
+	fprintf(out, "   do not edit, change the script and run make */\n\n");
+	fprintf(out, "#ifndef __DOT_ANIM__\n#define __DOT_ANIM__\n\n");
+	fprintf(out, "#define DOT_ANIM_FRAMES %d\n\n", frame_count);
+	for(i=0;i<anim_count;i++){
+		upper(name, anims[i].name);
+		fprintf(out, "#define DOT_ANIM_%s %d\n", name, i);
+	}
+	fprintf(out, "#define DOT_ANIMS %d\n\n", anim_count);
+
+	fprintf(out, "// first frame and number of frames of each animation\n");
+	fprintf(out, "static const struct dot_anim{\n\tconst char *name;\n\tint first;\n\tint count;\n} dot_anims[DOT_ANIMS] = {\n");
+	for(i=0;i<anim_count;i++)
+		fprintf(out, "\t{\"%s\", %d, %d},\n", anims[i].name, anims[i].first, anims[i].count);
+	fprintf(out, "};\n\n");
+
+	fprintf(out, "static const unsigned char dot_frames[DOT_ANIM_FRAMES][10] = {\n");
+	for(i=0;i<frame_count;i++){
+		fprintf(out, "\t{");
+		for(r=0;r<DOT_ROWS;r++)
+			fprintf(out, "0x%02x%s", frames[i][r], r < DOT_ROWS - 1 ? "," : "");
+		fprintf(out, "},\n");
+	}
+	fprintf(out, "};\n\n#endif\n");
+	fclose(out);
+
+	printf("%d animations, %d frames\n", anim_count, frame_count);
+	return 0;
+}
@@ -0,0 +1,24 @@
+/* Buzzer of fpga_core (/dev/fpga_buzzer)
+   write() of whole notes replaces the melody and returns at once,
+   the driver plays it from an hrtimer without any more system calls,
+   FPGA_BUZZER_WAIT (or poll for POLLIN) returns when the melody ends,
+   1 byte write (0 off, 1 on) of old driver still works and stops the melody */
+
+#ifndef __FPGA_BUZZER__
+#define __FPGA_BUZZER__
+
+#include <linux/ioctl.h>
+
+#define FPGA_BUZZER_NOTES 256		// longest melody
+
+// board buzzer has one tone, any tone other than 0 sounds it
+struct fpga_note{
+	unsigned short tone;		// 0 is rest
+	unsigned short ms;		// duration
+};
+
+#define FPGA_BUZZER_MAGIC 'B'
+#define FPGA_BUZZER_WAIT _IO(FPGA_BUZZER_MAGIC, 0)
+#define FPGA_BUZZER_STOP _IO(FPGA_BUZZER_MAGIC, 1)
+
+#endif
@@ -1,9 +1,12 @@
+#define _GNU_SOURCE
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
 #include <linux/input.h>
 
 #include <stdio.h>
@@ -15,7 +18,15 @@
 #include <time.h>
 #include <signal.h>
 #include <string.h>
-#include "./fpga_dot_font.h"
+#include <ctype.h>
+#include <sched.h>
+#include <pthread.h>
+#include "./dot_font.h"
+#include "./dot_anim.h"
+#include "./fpga_buzzer.h"
+#include "./fpga_motor.h"
+#include "./device.h"
+#include "./t9.h"
 
 #define IO_GPL_BASE_ADDR 0x11000000
 #define FND_GPL2CON 0x0100
@@ -32,12 +43,31 @@
 #define BUFF_SIZE 32
 #define MAX_BUTTON 9
 #define LINE_BUFF 16
-#define FPGA_NUMBER 18
-#define RUN 8
 
 #define KEY_RELEASE 0
 #define KEY_PRESS 1
 
+#define SCAN_HELD 1000		// switch scan period while key held (us)
+#define SCAN_ACTIVE 5000	// scan period while multi-tap is pending (us)
+#define SCAN_IDLE 50000		// maximum scan period when idle (us)
+#define MULTITAP_WINDOW 1000000	// multi-tap pending after release (us)
+
+#define FND_SHM 42		// fnd digit segments in output_shm (mode 1)
+#define FND_DIGITS 4
+#define JITTER_SLOT 64		// refresh jitter histogram (10us per slot)
+#define FND_SLOTS (FND_DIGITS * 2)	// lit and blank slot per digit
+#define BRIGHTNESS_STEP 10	// brightness change per SIGUSR1/SIGUSR2 (%)
+#define BLANK_STEP 10		// blanking change per SIGRTMIN/SIGRTMIN+1 (us)
+#define STOPWATCH_WAIT 10000	// stop watch tick check period (us)
+#define LCD_SHM 5		// text lcd window in output_shm (mode 2)
+#define LCD_SIZE 32
+#define DOC_SIZE 256		// initial size of text document
+#define DOT_SIZE 10		// bytes of one dot matrix frame
+
+#define IPC_WAIT 10000		// idle wait of threaded runtime (us)
+#define REAP_WAIT 1000000	// wait for other roles to finish (us)
+#define THREAD_STACK (64 * 1024)	// stack of every thread (locked by mlockall)
+
 #define SW1 139
 #define SW2 102
 #define SW3 158
@@ -46,14 +76,157 @@
 #define SW_DOWN 114
 #define SW_QUIT 116
 
-int mode_shmid, input_shmid, output_shmid;
-key_t mode_key, input_key, output_key;
+// keypress-to-display measurement (shared by all roles)
+struct bench{
+	volatile long long key_time;	// time of last mode change key (us)
+	unsigned int count;
+	unsigned int hist[LATENCY_SLOT];
+};
+
+// FND brightness, changed at runtime by signal to any role (rebuilt by refresh thread)
+struct tune{
+	volatile int duty[FND_DIGITS];	// lit time of digit (%)
+	volatile int blank;		// blanking before next digit (us)
+	volatile int generation;	// increased on every change
+};
+
+int mode_shmid, input_shmid, output_shmid, bench_shmid, tune_shmid;
+key_t mode_key, input_key, output_key, bench_key, tune_key;
 char *mode_shm, *input_shm, *output_shm;
+struct bench *bench_shm;
+struct tune *tune_shm;
+
+// text document of editor (gap buffer, gap is at cursor)
+struct document{
+	char *buf;
+	int size;	// allocated bytes
+	int gap;	// start of gap (cursor position)
+	int gap_end;	// end of gap
+	int top;	// first character in LCD window
+};
+
+static struct document doc;
+
+// T9 word prediction (typing mode 'T', needs dictionary file)
+static const char *t9_path = "t9.dict";
+static struct t9_dict t9;
+static struct t9_state t9_word;	// word being typed, ends on any other edit
+static int t9_shown;		// characters of word in document
+
+void doc_clear(void);
+void doc_render(void);
+void doc_insert(char c);
+void doc_replace(char c);
+void doc_backspace(void);
+void doc_left(void);
+void doc_right(void);
+void t9_commit(void);
+void t9_show(void);
+int typing_t9(void);
+static void fnd_tune(int sig);
+
+// FND refresh thread configuration (set by command line)
+static int refresh_rate = 100;		// full FND scans per second
+static int refresh_priority = 80;	// SCHED_FIFO priority, 0 for default
+static int refresh_cpu = 1;		// cpu of refresh thread, -1 for any
+
+// dot matrix animation of custom mode (frames per second set by command line)
+static int anim_fps = 10;
+
+// input record / replay of device backend (set by command line)
+static const char *record_path, *replay_path;
+static int replay_speed = 1;		// times faster than recorded
+
+// FND brightness of command line, starting values of tune_shm
+static int fnd_duty[FND_DIGITS] = {100, 100, 100, 100};	// lit time of digit (%)
+static int fnd_blank = 50;	// blanking before next digit (us)
+
+// monotonic time in micro seconds
+static long long now_us(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// attributes of a new thread, default stack would be locked in whole
+static void thread_attr(pthread_attr_t *attr){
+	pthread_attr_init(attr);
+	pthread_attr_setstacksize(attr, THREAD_STACK);
+}
+
+// print latency percentiles from histogram
+static void print_latency(const char *name, unsigned int *hist, unsigned int count){
+	unsigned int seen = 0;
+	int i, p50 = -1, p90 = -1, p99 = -1;
+
+	if(count == 0)
+		return;
+
+	for(i=0;i<LATENCY_SLOT;i++){
+		seen += hist[i];
+		if(p50 < 0 && seen * 100 >= count * 50)
+			p50 = i;
+		if(p90 < 0 && seen * 100 >= count * 90)
+			p90 = i;
+		if(p99 < 0 && seen * 100 >= count * 99)
+			p99 = i;
+	}
+
+	printf("DEBUG: %s latency (%u samples) p50 <%dms p90 <%dms p99 <%dms\n",
+			name, count, p50 + 1, p90 + 1, p99 + 1);
+}
+
+#ifdef THREADED
+// runtime with roles as threads of one process
+// shared memory is plain process memory, idle roles sleep on condition
+static pthread_mutex_t ipc_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ipc_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int ipc_generation;
+
+// wake up roles waiting for change of shared data
+static void ipc_notify(void){
+	pthread_mutex_lock(&ipc_lock);
+	ipc_generation++;
+	pthread_cond_broadcast(&ipc_cond);
+	pthread_mutex_unlock(&ipc_lock);
+}
+
+// wait until shared data changed (or timeout in us)
+static void ipc_wait(long timeout){
+	struct timespec ts;
+	unsigned int generation;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += timeout / 1000000;
+	ts.tv_nsec += (timeout % 1000000) * 1000;
+	if(ts.tv_nsec >= 1000000000){
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&ipc_lock);
+	generation = ipc_generation;
+	while(generation == ipc_generation)
+		if(pthread_cond_timedwait(&ipc_cond, &ipc_lock, &ts) != 0)
+			break;
+	pthread_mutex_unlock(&ipc_lock);
+}
+#else
+// processes poll shared memory, idle roles sleep instead of spinning
+// (a SCHED_FIFO role spinning would starve the others)
+static void ipc_notify(void){}
+static void ipc_wait(long timeout){
+	usleep(timeout);
+}
+#endif
 
 // function to print error
 static void die(char *str){
 	perror(str);
-	*mode_shm = '0';
+	// roles may not exist yet (shared memory not created)
+	if(mode_shm != NULL && mode_shm != (char *)-1)
+		*mode_shm = '0';
 	exit(1);
 }
 
@@ -78,9 +251,19 @@ static void init_shared(void){
 
 	for(i=5;i<42;i++)
 		output_shm[i] = ' ';
+
+	// stop watch digits "0000"
+	memset(output_shm + FND_SHM, 0x03, FND_DIGITS);
 }
 
 static void free_shared(void){
+#ifdef THREADED
+	free(mode_shm);
+	free(input_shm);
+	free(output_shm);
+	free(bench_shm);
+	free(tune_shm);
+#else
 	// dettach the segments from memory space
 	shmdt((char *)mode_shm);
 	shmdt((char *)input_shm);
@@ -90,14 +273,29 @@ static void free_shared(void){
 	shmctl(mode_shmid, IPC_RMID, (struct shmid_ds *)NULL);
 	shmctl(input_shmid, IPC_RMID, (struct shmid_ds *)NULL);
 	shmctl(output_shmid, IPC_RMID, (struct shmid_ds *)NULL);
+	shmdt((char *)bench_shm);
+	shmctl(bench_shmid, IPC_RMID, (struct shmid_ds *)NULL);
+	shmdt((char *)tune_shm);
+	shmctl(tune_shmid, IPC_RMID, (struct shmid_ds *)NULL);
+#endif
 }
 
 // create and initialize shared memory to use
 static int shared_memory(void){
+#ifdef THREADED
+	// every role is in this process, plain memory is enough
+	if((mode_shm = calloc(1, 1)) == NULL || (input_shm = calloc(1, 32)) == NULL
+			|| (output_shm = calloc(1, 64)) == NULL
+			|| (bench_shm = calloc(1, sizeof(struct bench))) == NULL
+			|| (tune_shm = calloc(1, sizeof(struct tune))) == NULL)
+		die("calloc");
+#else
 	// naming shared memory segments
 	mode_key = 1111;
 	input_key = 2222;
 	output_key = 3333;
+	bench_key = 4444;
+	tune_key = 5555;
 
 	// create the segments
 	if((mode_shmid = shmget(mode_key, 1, IPC_CREAT|0600)) < 0)
@@ -106,6 +304,10 @@ static int shared_memory(void){
 		die("input shmget");
 	if((output_shmid = shmget(output_key, 64, IPC_CREAT|0666)) < 0)
 		die("output shmget");
+	if((bench_shmid = shmget(bench_key, sizeof(struct bench), IPC_CREAT|0666)) < 0)
+		die("bench shmget");
+	if((tune_shmid = shmget(tune_key, sizeof(struct tune), IPC_CREAT|0666)) < 0)
+		die("tune shmget");
 
 	// attach the segments to memory space
 	if((mode_shm = shmat(mode_shmid, NULL, 0)) == (char *)-1)
@@ -114,10 +316,27 @@ static int shared_memory(void){
 		die("input shmat");
 	if((output_shm = shmat(output_shmid, NULL, 0)) == (char *)-1)
 		die("output shmat");
+	if((bench_shm = shmat(bench_shmid, NULL, 0)) == (struct bench *)-1)
+		die("bench shmat");
+	memset(bench_shm, 0, sizeof(struct bench));
+	if((tune_shm = shmat(tune_shmid, NULL, 0)) == (struct tune *)-1)
+		die("tune shmat");
+#endif
 
 	// initialize data to default
 	*mode_shm = '1';
 	init_shared();
+	memcpy((int *)tune_shm->duty, fnd_duty, sizeof(fnd_duty));
+	tune_shm->blank = fnd_blank;
+	tune_shm->generation = 0;
+
+	// runtime brightness control, state is shared so any role may be signalled
+	signal(SIGUSR1, fnd_tune);
+	signal(SIGUSR2, fnd_tune);
+	signal(SIGRTMIN, fnd_tune);
+	signal(SIGRTMIN + 1, fnd_tune);
+	printf("DEBUG: FND tune, kill -USR1 / -USR2 (brightness) -RTMIN / -RTMIN+1 (blanking) %d\n", getpid());
+	fflush(stdout);	// not again in buffers of forked roles
 
 	return 0;
 }
@@ -145,8 +364,8 @@ static int main_process(void){
 
 // function for stop watch (mode 1) calculation
 int cal_stopwatch(void){
-	int i, ttime, flag = 1;
-	time_t start_time, end_time;
+	int ttime, flag = 1;
+	long long start_time;
 	unsigned long fnd_num[10] = {0x03, 0x9F, 0x25, 0x0D, 0x99, 0x49, 0xC1, 0x1F, 0x01, 0x09};
 
 	printf("DEBUG: stop watch function entered\n");
@@ -156,36 +375,22 @@ int cal_stopwatch(void){
 			output_shm[0] = 0x96;	// gpe_dat
 			output_shm[1] = 0x03;	// gpl_dat
 			output_shm[2] = 0xE0;	// led_dat
+			memset(output_shm + FND_SHM, 0x03, FND_DIGITS);
+			ipc_wait(IPC_WAIT);
 		} else{
+			// absolute one second deadlines, late wakeups do not add up
+			start_time = now_us();
 			while((*input_shm == '3' || *input_shm == '4') && *mode_shm == '1'){
-				time(&start_time);
-				end_time = 0;
-
-				// run statement approximately one second
-				while(difftime(end_time, start_time) <= 0.999){
-					for(i=0;i<400;i++){
-						output_shm[0] = 0x02;
-						output_shm[1] = fnd_num[ttime/60/10];
-					}
-
-					for(i=0;i<400;i++){
-						output_shm[0] = 0x04;
-						output_shm[1] = fnd_num[ttime/60%10] - 0x01;
-					}
-
-					for(i=0;i<400;i++){
-						output_shm[0] = 0x10;
-						output_shm[1] = fnd_num[ttime%60/10];
-					}
-
-					for(i=0;i<400;i++){
-						output_shm[0] = 0x80;
-						output_shm[1] = fnd_num[ttime%60%10];
-					}
+				// publish digits, refresh thread of output multiplexes them
+				output_shm[FND_SHM] = fnd_num[ttime/60/10];
+				output_shm[FND_SHM + 1] = fnd_num[ttime/60%10] - 0x01;
+				output_shm[FND_SHM + 2] = fnd_num[ttime%60/10];
+				output_shm[FND_SHM + 3] = fnd_num[ttime%60%10];
 
-					// get time for calculating one second
-					time(&end_time);
-				}
+				// wait one second
+				start_time += 1000000;
+				while(now_us() < start_time)
+					usleep(STOPWATCH_WAIT);
 
 				// managing led driver during mode 1
 				if(*input_shm == '4'){
@@ -219,6 +424,11 @@ int cal_texteditor(void){
 	printf("DEBUG: text editor function entered\n");
 
 	typing_count(0); // initialize counter on FND
+	doc_clear();
+	t9_reset(&t9_word);
+	t9_shown = 0;
+	if(t9.head == NULL && t9_open(&t9, t9_path) < 0)
+		printf("DEBUG: %s not loaded, no T9 mode\n", t9_path);
 
 	while(*mode_shm == '2'){
 		if(input_shm[10] != '*'){
@@ -231,6 +441,41 @@ int cal_texteditor(void){
 			// clear lcd screen, if btn4 & btn5 are pressed
 			else if(input_shm[3] == 1 && input_shm[4] == 1){
 				init_shared();
+				doc_clear();
+				t9_commit();
+			}
+
+			// move cursor left, if btn1 & btn2 are pressed
+			else if(input_shm[0] == 1 && input_shm[1] == 1){
+				t9_commit();
+				doc_left();
+				typing_count(2);
+			}
+
+			// move cursor right, if btn3 & btn4 are pressed
+			else if(input_shm[2] == 1 && input_shm[3] == 1){
+				t9_commit();
+				doc_right();
+				typing_count(2);
+			}
+
+			// delete character before cursor, if btn7 & btn8 are pressed
+			// (last key of word being predicted in T9 mode)
+			else if(input_shm[6] == 1 && input_shm[7] == 1){
+				if(output_shm[0] == 'T' && t9_word.len > 0){
+					t9_back(&t9, &t9_word);
+					t9_show();
+				}
+				else
+					doc_backspace();
+				typing_count(2);
+			}
+
+			// next word of same keys, if btn6 & btn7 are pressed (T9 mode)
+			else if(input_shm[5] == 1 && input_shm[6] == 1){
+				if(output_shm[0] == 'T' && t9_next(&t9, &t9_word) > 1)
+					t9_show();
+				typing_count(2);
 			}
 
 			// change typing mode, if btn5 & btn6 are pressed
@@ -249,6 +494,10 @@ int cal_texteditor(void){
 					// calculation for alphabet mode
 					typing_alphabet();
 				}
+				else if(output_shm[0] == 'T'){
+					// calculation for T9 mode
+					typing_t9();
+				}
 				else{
 					// calculation for numeric mode
 					typing_numeric();
@@ -260,6 +509,8 @@ int cal_texteditor(void){
 			// flag down to wait new input
 			input_shm[10] = '*';
 		}
+		else
+			ipc_wait(IPC_WAIT);
 	}
 
 	printf("DEBUG: text editor function ended\n");
@@ -267,11 +518,15 @@ int cal_texteditor(void){
 }
 
 // change typing mode (alphabet <-> numeric)
+// (alphabet -> numeric -> T9 if dictionary is loaded)
 int typing_mode(void){
 	if(output_shm[0] == 'A')
 		output_shm[0] = 'N';
+	else if(output_shm[0] == 'N' && t9.head != NULL)
+		output_shm[0] = 'T';
 	else
 		output_shm[0] = 'A';
+	t9_commit();
 
 	output_shm[39] = '\0';
 	output_shm[40] = '\0';
@@ -282,11 +537,12 @@ int typing_mode(void){
 // count number of typing
 int typing_count(int count){
 	int i, num;
-	char temp[4];
+	char temp[5];
 
 	// get count data from shared memory
 	for(i=0;i<4;i++)
 		temp[i] = output_shm[i+1];
+	temp[4] = '\0';
 
 	num = atoi(temp) + count;
 	if(num > 9999)
@@ -312,149 +568,185 @@ int typing_clear(void){
 	return 0;
 }
 
+// empty document, cursor at beginning
+void doc_clear(void){
+	if(doc.buf == NULL){
+		if((doc.buf = malloc(DOC_SIZE)) == NULL)
+			die("document malloc");
+		doc.size = DOC_SIZE;
+	}
+
+	doc.gap = 0;
+	doc.gap_end = doc.size;
+	doc.top = 0;
+	doc_render();
+}
+
+// character at position of text (gap skipped)
+static char doc_at(int pos){
+	if(pos < doc.gap)
+		return doc.buf[pos];
+	return doc.buf[pos + doc.gap_end - doc.gap];
+}
+
+static int doc_length(void){
+	return doc.size - (doc.gap_end - doc.gap);
+}
+
+// copy LCD window around cursor to shared memory (32 characters only)
+void doc_render(void){
+	int i, len = doc_length();
+
+	// scroll window so cursor stays visible
+	if(doc.gap < doc.top)
+		doc.top = doc.gap;
+	else if(doc.gap >= doc.top + LCD_SIZE)
+		doc.top = doc.gap - LCD_SIZE + 1;
+
+	for(i=0;i<LCD_SIZE;i++)
+		output_shm[LCD_SHM + i] = (doc.top + i < len) ? doc_at(doc.top + i) : ' ';
+}
+
+// insert character at cursor (gap grows by doubling when full)
+void doc_insert(char c){
+	char *buf;
+	int tail;
+
+	if(doc.gap == doc.gap_end){
+		if((buf = realloc(doc.buf, doc.size * 2)) == NULL)
+			die("document realloc");
+		tail = doc.size - doc.gap_end;
+		memmove(buf + doc.size * 2 - tail, buf + doc.gap_end, tail);
+		doc.buf = buf;
+		doc.gap_end = doc.size * 2 - tail;
+		doc.size *= 2;
+	}
+
+	doc.buf[doc.gap++] = c;
+}
+
+// replace character before cursor (multiple press of a button)
+void doc_replace(char c){
+	if(doc.gap > 0)
+		doc.buf[doc.gap - 1] = c;
+}
+
+void doc_backspace(void){
+	if(doc.gap > 0)
+		doc.gap--;
+	output_shm[39] = '\0';
+	doc_render();
+}
+
+void doc_left(void){
+	if(doc.gap > 0)
+		doc.buf[--doc.gap_end] = doc.buf[--doc.gap];
+	output_shm[39] = '\0';
+	doc_render();
+}
+
+void doc_right(void){
+	if(doc.gap_end < doc.size)
+		doc.buf[doc.gap++] = doc.buf[doc.gap_end++];
+	output_shm[39] = '\0';
+	doc_render();
+}
+
 // alphabet mode typing
 int typing_alphabet(void){
-	int i=0, j=0, flag=0, k=0;
-	char *s;
+	int j;
 	char char_set[MAX_BUTTON][3] = {{'.', 'Q', 'Z'}, {'A', 'B', 'C'},
 					{'D', 'E', 'F'}, {'G', 'H', 'I'},
 					{'J', 'K', 'L'}, {'M', 'N', 'O'},
 					{'P', 'R', 'S'}, {'T', 'U', 'V'},
 					{'W', 'X', 'Y'}};
 
-	// find empty space for string buffer
-	s = output_shm;
-	while(*s != ' '){
-		if(*s == '*')
-			break;
-		s++;
-		i++;
-	}
-
 	// check which button is pressed
 	for(j=0;j<MAX_BUTTON;j++){
 		if(input_shm[j] == 1)
 			break;
 	}
+	if(j == MAX_BUTTON)
+		return 0;
 
 	// output_shm[39] == character pressed just before
 	// output_shm[40] == character for multiple press (change alphabet)
-	// if string buffer is full, push to left
-	if(i == 37){
-		// button pressed is different from previous one
-		if(output_shm[39] != ('1'+j)){
-			for(k=5;k<37;k++)
-				output_shm[k] = output_shm[k+1];
-			output_shm[36] = char_set[j][0];
-			output_shm[39] = '1'+j;
-			output_shm[40] = 0;
-		}
-
-		// button pressed is same with previous one
-		else{
-			// decide which character should be written on memory
-			if(output_shm[40] == 0){
-				output_shm[36] = char_set[j][1];
-				output_shm[40] = 1;
-			}
-			else if(output_shm[40] == 1){
-				output_shm[36] = char_set[j][2];
-				output_shm[40] = 2;
-			}
-			else{
-				output_shm[36] = char_set[j][0];
-				output_shm[40] = 0;
-			}
-		}
+	// button pressed is different from previous one
+	if(output_shm[39] != ('1'+j)){
+		doc_insert(char_set[j][0]);
+		output_shm[39] = '1'+j;
+		output_shm[40] = 0;
 	}
-	// if string buffer is not full,
-	// write character on proper position
-	else{
-		// button pressed is different from previous one
-		if(output_shm[39] != ('1'+j)){
-			output_shm[i] = char_set[j][0];
-			output_shm[39] = '1'+j;
-			output_shm[40] = 0;
-		}
 
-		// button pressed is same with previous one
-		else{
-			// decide which character should be written on memory
-			if(output_shm[40] == 0){
-				output_shm[i-1] = char_set[j][1];
-				output_shm[40] = 1;
-			}
-			else if(output_shm[40] == 1){
-				output_shm[i-1] = char_set[j][2];
-				output_shm[40] = 2;
-			}
-			else{
-				output_shm[i-1] = char_set[j][0];
-				output_shm[40] = 0;
-			}
-		}
+	// button pressed is same with previous one,
+	// change character before cursor
+	else{
+		output_shm[40] = (output_shm[40] + 1) % 3;
+		doc_replace(char_set[j][(int)output_shm[40]]);
 	}
 
+	doc_render();
 	return 0;
 }
 
-// numeric mode typing
-int typing_numeric(void){
-	int i = 0, j;
-	char *s;
+// word typed so far is kept, next key starts new word
+void t9_commit(void){
+	t9_reset(&t9_word);
+	t9_shown = 0;
+}
 
-	// check for empty space for input
-	s = output_shm;
-	while(*s != ' '){
-		if(*s == '*')
-			break;
-		s++;
-		i++;
-	}
+// replace word before cursor with prediction of its keys
+void t9_show(void){
+	char text[T9_WORD];
+	int i, len;
 
-	// if buffer is reached to max, shift it left
-	if(i == 37){
-		for(j=5;j<37;j++)
-			output_shm[j] = output_shm[j+1];
-		i = 36;
-	}
+	len = t9_text(&t9, &t9_word, text);
+
+	doc.gap -= t9_shown;
+	for(i=0;i<len;i++)
+		doc_insert(toupper((unsigned char)text[i]));
+	t9_shown = len;
+
+	doc_render();
+}
+
+// T9 mode typing, one key per letter
+int typing_t9(void){
+	int j;
 
 	// check which button is pressed
 	for(j=0;j<MAX_BUTTON;j++){
 		if(input_shm[j] == 1)
 			break;
 	}
+	if(j == MAX_BUTTON)
+		return 0;
 
-	// copy number to shared memory to print
-	switch(j+1){
-		case 1:
-			output_shm[i] = '1';
-			break;
-		case 2:
-			output_shm[i] = '2';
-			break;
-		case 3:
-			output_shm[i] = '3';
-			break;
-		case 4:
-			output_shm[i] = '4';
-			break;
-		case 5:
-			output_shm[i] = '5';
-			break;
-		case 6:
-			output_shm[i] = '6';
-			break;
-		case 7:
-			output_shm[i] = '7';
-			break;
-		case 8:
-			output_shm[i] = '8';
-			break;
-		case 9:
-			output_shm[i] = '9';
+	// word is too long to predict, start new one
+	if(t9_word.len == T9_WORD)
+		t9_commit();
+
+	t9_key(&t9, &t9_word, j);
+	t9_show();
+
+	return 0;
+}
+
+// numeric mode typing
+int typing_numeric(void){
+	int j;
+
+	// check which button is pressed
+	for(j=0;j<MAX_BUTTON;j++){
+		if(input_shm[j] == 1)
 			break;
 	}
+	if(j == MAX_BUTTON)
+		return 0;
+
+	// insert number at cursor
+	doc_insert('1'+j);
+	doc_render();
 
 	return 0;
 }
@@ -504,71 +796,117 @@ int cal_custom(void){
 	return 0;
 }
 
+// apply one key press to local copy of mode / input
+static void eventkey_handle(int code, char *mode, char *input, int *reset){
+	// stop watch button input
+	if(*mode == '1'){
+		if(code == SW2)
+			*input = '2';
+		if(code == SW3)
+			*input = '3';
+		if(code == SW4)
+			*input = '4';
+	}
+
+	// custom mode button input
+	if(*mode == '3'){
+		if(code == SW1)
+			*input = '1';
+		if(code == SW2)
+			*input = '2';
+		if(code == SW3)
+			*input = '3';
+		if(code == SW4)
+			*input = '4';
+	}
+
+	// mode change upward
+	if(code == SW_UP){
+		if(*mode == '1')
+			*mode = '2';
+		else if(*mode == '2')
+			*mode = '3';
+		else
+			*mode = '1';
+
+		*input = 0;	// input is cleared by init_shared()
+		*reset = 1;
+	}
+
+	// mode change downward
+	if(code == SW_DOWN){
+		if(*mode == '1')
+			*mode = '3';
+		else if(*mode == '2')
+			*mode = '1';
+		else
+			*mode = '2';
+
+		*input = 0;
+		*reset = 1;
+	}
+
+	// terminate program
+	if(code == SW_QUIT)
+		*mode = '0';
+}
+
 // get all event keys and pass it to main process
 static int eventkey_process(void){
 	struct input_event ev[BUFF_SIZE];
-	int fd, rd, value, size = sizeof(struct input_event);
+	int fd, rd, i, size = sizeof(struct input_event);
+	int frame[BUFF_SIZE], frame_len = 0;
+	int dropping = 0;	// after SYN_DROPPED until next SYN_REPORT
+	int j, reset, changed;
+	char mode, input;
 
 	// open device driver
-	if((fd = open("/dev/input/event1", O_RDONLY)) < 0)
+	if((fd = dev_open("/dev/input/event1", O_RDONLY)) < 0)
 		die("/dev/input/event1 open error");
 
 	printf("DEBUG: event key process entered\n");
 	while(*mode_shm != '0'){
-		// get event key
-		if((rd = read(fd, ev, size*BUFF_SIZE)) < size)
+		// get event key (all events ready in one read)
+		if((rd = dev_read(fd, ev, size*BUFF_SIZE)) < size)
 			die("read()");
 
-		if(ev[0].value == KEY_PRESS){
-			// stop watch button input
-			if(*mode_shm == '1'){
-				if(ev[0].code == SW2)
-					*input_shm = '2';
-				if(ev[0].code == SW3)
-					*input_shm = '3';
-				if(ev[0].code == SW4)
-					*input_shm = '4';
-			}
+		mode = *mode_shm;
+		input = 0;
+		reset = 0;
+		changed = 0;
 
-			// custom mode button input
-			if(*mode_shm == '3'){
-				if(ev[0].code == SW1)
-					*input_shm = '1';
-				if(ev[0].code == SW2)
-					*input_shm = '2';
-				if(ev[0].code == SW3)
-					*input_shm = '3';
-				if(ev[0].code == SW4)
-					*input_shm = '4';
+		// walk whole batch, key presses are applied per SYN_REPORT frame
+		for(i=0;i<rd/size;i++){
+			if(ev[i].type == EV_KEY && ev[i].value == KEY_PRESS){
+				if(!dropping && frame_len < BUFF_SIZE)
+					frame[frame_len++] = ev[i].code;
 			}
-
-			// mode change upward
-			if(ev[0].code == SW_UP){
-				if(*mode_shm == '1')
-					*mode_shm = '2';
-				else if(*mode_shm == '2')
-					*mode_shm = '3';
-				else
-					*mode_shm = '1';
-
-				init_shared();
+			else if(ev[i].type == EV_SYN && ev[i].code == SYN_REPORT){
+				dropping = 0;	// frame is empty when it ends a dropped one
+				for(j=0;j<frame_len;j++)
+					eventkey_handle(frame[j], &mode, &input, &reset);
+				changed |= frame_len;
+				frame_len = 0;
 			}
-
-			// mode change downward
-			if(ev[0].code == SW_DOWN){
-				if(*mode_shm == '1')
-					*mode_shm = '3';
-				else if(*mode_shm == '2')
-					*mode_shm = '1';
-				else
-					*mode_shm = '2';
-
-				init_shared();
+			else if(ev[i].type == EV_SYN && ev[i].code == SYN_DROPPED){
+				// events are lost, discard all up to and including next SYN_REPORT
+				frame_len = 0;
+				dropping = 1;
 			}
+		}
 
-			// terminate program
-			if(ev[0].code == SW_QUIT)
-				*mode_shm = '0';
+		// publish the whole batch in one update
+		// (incomplete frame is kept until its SYN_REPORT arrives)
+		if(changed){
+			if(mode != *mode_shm){
+				*mode_shm = mode;
+				bench_shm->key_time = now_us();
+			}
+			if(reset)
+				init_shared();
+			if(input != 0)
+				*input_shm = input;
+			ipc_notify();
 		}
 	}
 
@@ -583,31 +921,38 @@ static int eventkey_process(void){
 static int input_process(void){
 	int i, dev, buff_size, flag;
 	unsigned char push_sw_buff[MAX_BUTTON];
+	long long now, last_scan, last_active = 0, seen = 0;
+	int scan = SCAN_ACTIVE, slot;
+	unsigned int latency[LATENCY_SLOT] = {0,}, presses = 0;
+	unsigned int gap[LATENCY_SLOT] = {0,}, seens = 0;
 
 	// open device driver
-	if((dev = open("/dev/fpga_push_switch", O_RDWR)) < 0)
+	if((dev = dev_open("/dev/fpga_push_switch", O_RDWR)) < 0)
 		die("/dev/fpga_push_switch open error");
 	buff_size = sizeof(push_sw_buff);
+	last_scan = now_us();
 
 	printf("DEBUG: input process entered\n");
 	while(*mode_shm != '0'){
-		// if mode is 1,
-		// sleep the process for better look (stop-watch blinking)
-		if(*mode_shm == '1')
-			sleep(1);
+		// switch is not used in mode 1 and 3, wait with idle period
+		if(*mode_shm != '2'){
+			usleep(SCAN_IDLE);
+			last_scan = now_us();
+		}
 
 		if(*mode_shm == '2'){
 			char *s;
 
 			flag = 0;
-			usleep(50000);
+			usleep(scan);
 
 			// check for alphabet/numeric mode
-			if(*output_shm != 'A' && *output_shm != 'N')
+			if(*output_shm != 'A' && *output_shm != 'N' && *output_shm != 'T')
 				*output_shm = 'A';
 
 			// read switch input
-			read(dev, &push_sw_buff, buff_size);
+			dev_read(dev, &push_sw_buff, buff_size);
+			now = now_us();
 
 			// check for input existence
 			for(i=0;i<MAX_BUTTON;i++){
@@ -615,10 +960,23 @@ static int input_process(void){
 					flag = 1;
 			}
 
+			// first scan seeing a press, it happened since last scan
+			if(flag && seen == 0){
+				seen = now;
+				slot = (now - last_scan) / 1000;
+				if(slot >= LATENCY_SLOT)
+					slot = LATENCY_SLOT - 1;
+				gap[slot]++;
+				seens++;
+			}
+			else if(!flag)
+				seen = 0;
+
 			// check if button released with changed
 			if(flag == 0 && input_shm[9] == '1' && input_shm[10] == '*'){
 				input_shm[9] = '0';
 				input_shm[10] = '0';	// notify main to calculate
+				ipc_notify();
 			}
 
 			// check if button is still pressed
@@ -638,36 +996,79 @@ static int input_process(void){
 					*s = push_sw_buff[i];
 					input_shm[9] = '1';
 				}
+
+				// published once main took previous input
+				slot = (now - seen) / 1000;
+				if(slot >= LATENCY_SLOT)
+					slot = LATENCY_SLOT - 1;
+				latency[slot]++;
+				presses++;
 			}
 
-			// initialize input buffer
-			else{
+			// initialize input buffer (unless main has not read it yet)
+			else if(input_shm[10] == '*'){
 				for(i=0, s=input_shm;i<MAX_BUTTON;i++, s++)
 					*s = push_sw_buff[i];
 			}
+
+			// scan fast while key is held or multi-tap may follow,
+			// back off exponentially when idle
+			if(flag){
+				scan = SCAN_HELD;
+				last_active = now;
+			}
+			else if(now - last_active < MULTITAP_WINDOW)
+				scan = SCAN_ACTIVE;
+			else if(scan < SCAN_IDLE){
+				scan *= 2;
+				if(scan > SCAN_IDLE)
+					scan = SCAN_IDLE;
+			}
+			last_scan = now;
 		}
 	}
 
 	// close device driver
 	close(dev);
 
+	print_latency("press scan gap", gap, seens);
+	print_latency("press-to-publish", latency, presses);
 	printf("DEBUG: input process ended\n");
 	return 0;
 }
 
 // get all data from main process and print it on device
+// record keypress-to-display latency of mode change
+static void bench_display(void){
+	long long key_time = bench_shm->key_time;
+	int slot;
+
+	if(key_time == 0)
+		return;
+	bench_shm->key_time = 0;
+
+	slot = (now_us() - key_time) / 1000;
+	if(slot >= LATENCY_SLOT)
+		slot = LATENCY_SLOT - 1;
+	bench_shm->hist[slot]++;
+	bench_shm->count++;
+}
+
 static int output_process(void){
 	printf("DEBUG: output process entered\n");
 	while(*mode_shm != '0'){
 		if(*mode_shm == '1'){
+			bench_display();
 			print_stopwatch();
 		}
 
 		if(*mode_shm == '2'){
+			bench_display();
 			print_texteditor();
 		}
 
 		if(*mode_shm == '3'){
+			bench_display();
 			print_custom();
 		}
 	}
@@ -676,9 +1077,199 @@ static int output_process(void){
 	return 0;
 }
 
+// FND refresh thread state
+struct refresh{
+	volatile int running;
+	volatile unsigned long *gpe_dat;
+	volatile unsigned long *gpl_dat;
+	volatile unsigned long *led_dat;
+	unsigned int jitter[JITTER_SLOT];
+	unsigned int count;
+	unsigned int missed;
+	long long max;		// worst lateness (ns)
+};
+
+// one timing slot of FND scan
+struct fnd_slot{
+	unsigned char sel;	// digit select, 0 while blanked
+	unsigned char digit;	// index of segment byte
+	long ns;		// length of slot
+};
+
+// SIGUSR1 brighter, SIGUSR2 dimmer, SIGRTMIN longer blanking, SIGRTMIN+1 shorter
+static void fnd_tune(int sig){
+	int i, step;
+
+	if(sig == SIGUSR1 || sig == SIGUSR2){
+		step = (sig == SIGUSR1) ? BRIGHTNESS_STEP : -BRIGHTNESS_STEP;
+		for(i=0;i<FND_DIGITS;i++){
+			if(tune_shm->duty[i] + step > 100)
+				tune_shm->duty[i] = 100;
+			else if(tune_shm->duty[i] + step < 0)
+				tune_shm->duty[i] = 0;
+			else
+				tune_shm->duty[i] += step;
+		}
+	} else{
+		step = (sig == SIGRTMIN) ? BLANK_STEP : -BLANK_STEP;
+		if(tune_shm->blank + step < 0)
+			tune_shm->blank = 0;
+		else
+			tune_shm->blank += step;
+	}
+	tune_shm->generation++;
+}
+
+// precompute scan slots, each digit is lit for its duty then blanked
+static int fnd_slots(struct fnd_slot *slot, long period){
+	static const unsigned char fnd_sel[FND_DIGITS] = {0x02, 0x04, 0x10, 0x80};
+	long lit, blank = tune_shm->blank * 1000L;
+	int i, n = 0;
+
+	if(blank > period)
+		blank = period;
+
+	for(i=0;i<FND_DIGITS;i++){
+		lit = (period - blank) * tune_shm->duty[i] / 100;
+		if(lit > 0){
+			slot[n].sel = fnd_sel[i];
+			slot[n].digit = i;
+			slot[n++].ns = lit;
+		}
+		if(period - lit > 0){
+			slot[n].sel = 0;
+			slot[n].digit = i;
+			slot[n++].ns = period - lit;
+		}
+	}
+
+	return n;
+}
+
+// multiplex FND digits at fixed rate, scan driven by slot table
+static void *refresh_thread(void *arg){
+	struct refresh *r = arg;
+	struct fnd_slot table[FND_SLOTS], *s;
+	struct timespec next, now;
+	long long late;
+	long period;
+	int i = 0, n = 0, generation = -1, slot;
+
+	period = 1000000000L / (refresh_rate * FND_DIGITS);
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	while(r->running){
+		// brightness changed, rebuild table at end of scan
+		if(i == 0 && generation != tune_shm->generation){
+			if(generation >= 0)
+				printf("DEBUG: FND duty %d,%d,%d,%d%% blank %dus\n", tune_shm->duty[0], tune_shm->duty[1],
+						tune_shm->duty[2], tune_shm->duty[3], tune_shm->blank);
+			generation = tune_shm->generation;
+			n = fnd_slots(table, period);
+		}
+		s = &table[i];
+		i = (i + 1) % n;
+
+		// blank before changing segments, no ghost of previous digit
+		*r->gpe_dat = 0;
+		if(s->sel != 0){
+			*r->gpl_dat = output_shm[FND_SHM + s->digit];
+			*r->gpe_dat = s->sel;
+			dev_shown(DEV_GPIO_FND, output_shm + FND_SHM, FND_DIGITS);
+		}
+		*r->led_dat = output_shm[2];
+
+		// absolute deadlines, sleeping late does not shift the schedule
+		next.tv_nsec += s->ns;
+		while(next.tv_nsec >= 1000000000){
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		late = (long long)(now.tv_sec - next.tv_sec) * 1000000000 + now.tv_nsec - next.tv_nsec;
+		if(late > r->max)
+			r->max = late;
+		slot = late / 10000;
+		if(slot >= JITTER_SLOT)
+			slot = JITTER_SLOT - 1;
+		r->jitter[slot]++;
+		r->count++;
+
+		// woke up after next slot was due, skip to present
+		if(late >= s->ns){
+			if(r->missed++ == 0)
+				printf("DEBUG: FND refresh missed deadline (%lldus late)\n", late / 1000);
+			next = now;
+		}
+	}
+
+	return NULL;
+}
+
+// start refresh thread with SCHED_FIFO priority and cpu affinity
+static int refresh_start(struct refresh *r, pthread_t *thread){
+	pthread_attr_t attr;
+	struct sched_param param;
+	cpu_set_t set;
+
+	// page faults would stall the refresh
+	if(mlockall(MCL_CURRENT|MCL_FUTURE) < 0)
+		printf("DEBUG: FND refresh memory not locked\n");
+
+	thread_attr(&attr);
+	if(refresh_priority > 0){
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		param.sched_priority = refresh_priority;
+		pthread_attr_setschedparam(&attr, &param);
+	}
+	if(refresh_cpu >= 0){
+		CPU_ZERO(&set);
+		CPU_SET(refresh_cpu, &set);
+		pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+	}
+
+	r->running = 1;
+	if(pthread_create(thread, &attr, refresh_thread, r) != 0){
+		// not privileged, run with default scheduling
+		printf("DEBUG: FND refresh not real-time\n");
+		pthread_attr_destroy(&attr);
+		thread_attr(&attr);
+		if(pthread_create(thread, &attr, refresh_thread, r) != 0)
+			die("refresh thread creation failed");
+	}
+	pthread_attr_destroy(&attr);
+
+	return 0;
+}
+
+// print refresh jitter percentiles and missed deadlines
+static void print_refresh(struct refresh *r){
+	unsigned int seen = 0;
+	int i, p50 = -1, p99 = -1;
+
+	if(r->count == 0)
+		return;
+
+	for(i=0;i<JITTER_SLOT;i++){
+		seen += r->jitter[i];
+		if(p50 < 0 && seen * 100 >= r->count * 50)
+			p50 = i;
+		if(p99 < 0 && seen * 100 >= r->count * 99)
+			p99 = i;
+	}
+
+	printf("DEBUG: FND refresh %dHz (%u slots) jitter p50 <%dus p99 <%dus max %lldus missed %u\n",
+			refresh_rate, r->count, (p50 + 1) * 10, (p99 + 1) * 10, r->max / 1000, r->missed);
+}
+
 // print stop watch using FND driver
 int print_stopwatch(void){
-	int fd, i;
+	int fd;
+	struct refresh r;
+	pthread_t thread;
 	void *gpl_addr, *gpe_addr, *baseaddr;
 	unsigned long *gpe_con = 0;
 	unsigned long *gpe_dat = 0;
@@ -690,10 +1281,10 @@ int print_stopwatch(void){
 	printf("DEBUG: print stop watch entered\n");
 
 	// open and initialize FND driver
-	if((fd = open("/dev/mem", O_RDWR|O_SYNC)) < 0)
+	if((fd = dev_open("/dev/mem", O_RDWR|O_SYNC)) < 0)
 		die("/dev/mem open error");
 
-	gpl_addr = (unsigned long *)mmap(NULL, 4096, PROT_READ|PROT_WRITE, MAP_SHARED, fd, IO_GPL_BASE_ADDR);
+	gpl_addr = (unsigned long *)dev_mmap(fd, IO_GPL_BASE_ADDR);
 	if(gpl_addr != NULL){
 		gpl_con = (unsigned long *)(gpl_addr + FND_GPL2CON);
 		gpl_dat = (unsigned long *)(gpl_addr + FND_GPL2DAT);
@@ -701,7 +1292,7 @@ int print_stopwatch(void){
 	if(*gpl_con == (unsigned long)-1 || *gpl_dat == (unsigned long)-1)
 		die("mmap error");
 
-	gpe_addr = (unsigned long *)mmap(NULL, 4096, PROT_READ|PROT_WRITE, MAP_SHARED, fd, IO_GPE_BASE_ADDR);
+	gpe_addr = (unsigned long *)dev_mmap(fd, IO_GPE_BASE_ADDR);
 	if(gpe_addr != NULL){
 		gpe_con = (unsigned long *)(gpe_addr + FND_GPE3CON);
 		gpe_dat = (unsigned long *)(gpe_addr + FND_GPE3DAT);
@@ -710,7 +1301,7 @@ int print_stopwatch(void){
 		die("mmap error");
 
 	// open and initialize LED driver
-	baseaddr = (unsigned long *)mmap(NULL, 4096, PROT_READ|PROT_WRITE, MAP_SHARED, fd, IO_BASE_ADDR);
+	baseaddr = (unsigned long *)dev_mmap(fd, IO_BASE_ADDR);
 	if(baseaddr != NULL){
 		led_con = (unsigned long *)(baseaddr + CON_OFFSET);
 		led_dat = (unsigned long *)(baseaddr + DAT_OFFSET);
@@ -719,13 +1310,19 @@ int print_stopwatch(void){
 		die("mmap error");
 	*led_con |= 0x11110000;
 
-	// update value of FND
-	while(*mode_shm == '1'){
-		*gpe_dat = output_shm[0];
-		*gpl_dat = output_shm[1];
-		*led_dat = output_shm[2];
-		*led_dat = output_shm[2];
-	}
+	// update value of FND from refresh thread
+	memset(&r, 0, sizeof(r));
+	r.gpe_dat = gpe_dat;
+	r.gpl_dat = gpl_dat;
+	r.led_dat = led_dat;
+	refresh_start(&r, &thread);
+
+	while(*mode_shm == '1')
+		usleep(SCAN_IDLE);
+
+	r.running = 0;
+	pthread_join(thread, NULL);
+	print_refresh(&r);
 
 	// set to default value
 	*gpe_dat = 0x96;
@@ -755,17 +1352,17 @@ int print_texteditor(void){
 	printf("DEBUG: print text editor entered\n");
 
 	// open and initialize fpga dot driver
-	if((fpga_dot = open("/dev/fpga_dot", O_WRONLY)) < 0)
+	if((fpga_dot = dev_open("/dev/fpga_dot", O_WRONLY)) < 0)
 		die("/dev/fpga_dot open error");
-	str_size = sizeof(fpga_number[FPGA_NUMBER]);
+	str_size = DOT_SIZE;
 
 	// open and initialize fpga fnd driver
-	if((fnd_dev = open("/dev/fpga_fnd", O_RDWR)) < 0)
+	if((fnd_dev = dev_open("/dev/fpga_fnd", O_RDWR)) < 0)
 		die("/dev/fpga_fnd open error");
 	memset(data, 0, sizeof(data));
 
 	// open and initialize fpga text driver
-	if((text_dev = open("/dev/fpga_text_lcd", O_WRONLY)) < 0)
+	if((text_dev = dev_open("/dev/fpga_text_lcd", O_WRONLY)) < 0)
 		die("/dev/fpga_text_lcd open error");
 	memset(string, 0, sizeof(string));
 
@@ -773,34 +1370,36 @@ int print_texteditor(void){
 	while(*mode_shm == '2'){
 		usleep(50000);
 
-		// typing mode (alphabet / numeric)
+		// typing mode (alphabet / numeric / T9)
 		if(output_shm[0] == 'N')
-			write(fpga_dot, fpga_number[1], str_size);
+			dev_write(fpga_dot, dot_glyph('1'), str_size);
+		else if(output_shm[0] == 'T')
+			dev_write(fpga_dot, dot_glyph('T'), str_size);
 		else
-			write(fpga_dot, fpga_number[10], str_size);
+			dev_write(fpga_dot, dot_glyph('A'), str_size);
 
 		// print number of count
 		for(i=0;i<4;i++)
 			data[i] = output_shm[i+1];
-		write(fnd_dev, &data, 4);
+		dev_write(fnd_dev, &data, 4);
 
 		// print text on lcd
 		if(output_shm[5] != '*'){
 			for(i=0;i<32;i++)
 				string[i] = output_shm[i+5];
 
-			write(text_dev, string, BUFF_SIZE);
+			dev_write(text_dev, string, BUFF_SIZE);
 		}
 	}
 
 	// set to default value for each device (just for clean look)
-	write(fpga_dot, fpga_number[10], str_size);
+	dev_write(fpga_dot, dot_glyph('A'), str_size);
 	for(i=0;i<4;i++)
 		data[i] = '0';
-	write(fnd_dev, &data, 4);
+	dev_write(fnd_dev, &data, 4);
 	for(i=0;i<32;i++)
 		string[i] = ' ';
-	write(text_dev, string, BUFF_SIZE);
+	dev_write(text_dev, string, BUFF_SIZE);
 
 	// close all device driver
 	close(fpga_dot);
@@ -811,91 +1410,180 @@ int print_texteditor(void){
 	return 0;
 }
 
+// dot matrix animation player state
+struct player{
+	volatile int running;
+	int dev;
+	const struct dot_anim *anim;
+	unsigned int frames;	// frame deadlines passed
+	unsigned int shown;	// frames written to device
+	unsigned int skipped;	// same as frame on display, not written
+	unsigned int dropped;	// deadline passed while late, never shown
+};
+
+// play compiled frames at anim_fps, write only frames that differ from display
+static void *player_thread(void *arg){
+	struct player *p = arg;
+	const unsigned char *frame, *last = NULL;
+	struct timespec next, now;
+	long long late;
+	long period = 1000000000L / anim_fps;
+	int i = 0, behind;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	while(p->running){
+		frame = dot_frames[p->anim->first + i];
+		if(last != NULL && memcmp(frame, last, DOT_SIZE) == 0)
+			p->skipped++;
+		else{
+			dev_write(p->dev, frame, DOT_SIZE);
+			p->shown++;
+		}
+		last = frame;
+
+		next.tv_nsec += period;
+		while(next.tv_nsec >= 1000000000){
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+
+		// woke up a whole frame late, frames due meanwhile are dropped
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		late = (long long)(now.tv_sec - next.tv_sec) * 1000000000 + now.tv_nsec - next.tv_nsec;
+		behind = late / period;
+		if(behind > 0){
+			p->dropped += behind;
+			next = now;
+		}
+
+		p->frames += behind + 1;
+		i = (i + behind + 1) % p->anim->count;
+	}
+
+	return NULL;
+}
+
+static void print_player(struct player *p){
+	if(p->frames == 0)
+		return;
+
+	printf("DEBUG: dot animation %s %dfps, %u frames, %u written, %u skipped, %u dropped\n",
+			p->anim->name, anim_fps, p->frames, p->shown, p->skipped, p->dropped);
+}
+
+// alarm of custom mode, sent to buzzer in one write and played by driver
+static const struct fpga_note alarm_melody[] = {
+	{1, 150}, {0, 100}, {1, 150}, {0, 100}, {1, 150}, {0, 400},
+	{1, 400}, {0, 200}, {1, 400}, {0, 200}, {1, 400}, {0, 400},
+	{1, 150}, {0, 100}, {1, 150}, {0, 100}, {1, 150}, {0, 800}
+};
+
+// custom mode motor, one queued move accelerates and runs until stopped
+static const struct fpga_motor_move motor_run = {0, 1000000, 200, 400};
+
+// start queued move in direction, or stop (3 byte write cancels the queue)
+static void motor_set(int dev, int on, int dir){
+	struct fpga_motor_move move = motor_run;
+	unsigned char stop[3] = {0, 0, 10};
+
+	stop[1] = dir;
+	dev_write(dev, stop, sizeof(stop));
+	if(on){
+		move.dir = dir;
+		dev_write(dev, &move, sizeof(move));
+	}
+}
+
 // print custom mode
 int print_custom(void){
 	int text_dev, i;
-	unsigned char string[32], j = 0;
+	unsigned char string[32];
 
 	int dot_dev, dot_size;
+	struct player player;
+	pthread_t thread;
+	pthread_attr_t attr;
 	int buzzer_dev;
-	int motor_dev, motor_size;
-	unsigned char motor_state[3] = {0, 0, 10};
+	int motor_dev, motor_on = 0, motor_dir = 0;
 	unsigned char data;
 
 	printf("DEBUG: print custom mode entered\n");
 
 	// open and initialize fpga text driver
-	if((text_dev = open("/dev/fpga_text_lcd", O_WRONLY)) < 0)
+	if((text_dev = dev_open("/dev/fpga_text_lcd", O_WRONLY)) < 0)
 		die("/dev/fpga_text_lcd open error");
 	memset(string, 0, sizeof(string));
 
 	// open and initialize fpga dot driver
-	if((dot_dev = open("/dev/fpga_dot", O_WRONLY)) < 0)
+	if((dot_dev = dev_open("/dev/fpga_dot", O_WRONLY)) < 0)
 		die("/dev/fpga_dot open error");
-	dot_size = sizeof(fpga_number[FPGA_NUMBER]);
+	dot_size = DOT_SIZE;
+
+	// animate dot matrix independently of one second loop below
+	memset(&player, 0, sizeof(player));
+	player.dev = dot_dev;
+	player.anim = &dot_anims[DOT_ANIM_HELPME];
+	player.running = 1;
+	thread_attr(&attr);
+	if(pthread_create(&thread, &attr, player_thread, &player) != 0)
+		die("dot animation thread creation failed");
+	pthread_attr_destroy(&attr);
 
 	// open and initialize fpga motor
-	motor_dev = open("/dev/fpga_step_motor", O_WRONLY);
+	motor_dev = dev_open("/dev/fpga_step_motor", O_WRONLY);
 
 	//open and initialize buzzer driver
-	buzzer_dev = open("/dev/fpga_buzzer", O_RDWR);
+	buzzer_dev = dev_open("/dev/fpga_buzzer", O_RDWR);
 	data = 0;
 
 	while(*mode_shm == '3'){
 		// print text on lcd display
 		for(i=0;i<32;i++)
 			string[i] = output_shm[i];
-		write(text_dev, string, BUFF_SIZE);
+		dev_write(text_dev, string, BUFF_SIZE);
 
-		// print text on dot driver
-		write(dot_dev, fpga_number[11+j], dot_size);
-		if(++j == RUN)
-			j = 0;
-
-		// check for motor state
+		// check for motor state, written only when it changes
+		// (reverse stops the running move and ramps up the other way)
 		if(output_shm[32] == '1'){
-			if(motor_state[0] == '1')
-				motor_state[0] = '0';
-			else
-				motor_state[0] = '1';
-
+			motor_on = !motor_on;
+			motor_set(motor_dev, motor_on, motor_dir);
 			output_shm[32] = '*';
 		}
 		else if(output_shm[32] == '2'){
-			if(motor_state[1] == '1')
-				motor_state[1] = '0';
-			else
-				motor_state[1] = '1';
-
+			motor_dir = !motor_dir;
+			if(motor_on)
+				motor_set(motor_dev, motor_on, motor_dir);
 			output_shm[32] = '*';
 		}
 
-		// check for buzzer state
+		// check for buzzer state, driver plays whole melody on its own
 		if(output_shm[32] == '3'){
-			data = 1;
+			dev_write(buzzer_dev, alarm_melody, sizeof(alarm_melody));
 			output_shm[32] = '*';
 		}
 		else if(output_shm[32] == '4'){
 			data = 0;
+			dev_write(buzzer_dev, &data, 1);
 			output_shm[32] = '*';
 		}
 
-		write(motor_dev, motor_state, 3);
-		write(buzzer_dev, &data, 1);
-
 		sleep(1);
 	}
 
+	player.running = 0;
+	pthread_join(thread, NULL);
+	print_player(&player);
+
 	// set display for default value (just for better look)
 	for(i=0;i<32;i++)
 		string[i] = ' ';
-	write(text_dev, string, BUFF_SIZE);
-	write(dot_dev, fpga_number[10], dot_size);
-	motor_state[0] = '0';
-	motor_state[1] = '0';
-	write(motor_dev, motor_state, 3);
+	dev_write(text_dev, string, BUFF_SIZE);
+	dev_write(dot_dev, dot_glyph('A'), dot_size);
+	motor_set(motor_dev, 0, 0);
 	data = 0;
-	write(buzzer_dev, &data, 1);
+	dev_write(buzzer_dev, &data, 1);
 
 
 	printf("DEBUG: print custom mode ended\n");
@@ -909,12 +1597,186 @@ int print_custom(void){
 	return 0;
 }
 
+// scheduling of each role (priority 0 keeps default policy, cpu -1 any cpu)
+struct role{
+	const char *name;
+	int (*run)(void);
+	int priority;
+	int cpu;
+};
+
+static struct role roles[] = {
+	{"event key", eventkey_process, 60, -1},
+	{"input", input_process, 50, -1},
+	{"output", output_process, 40, 1},
+	{"main", main_process, 30, 0},
+};
+
+// apply SCHED_FIFO priority and cpu affinity to calling thread
+static void role_setup(struct role *role){
+	struct sched_param param;
+	cpu_set_t set;
+
+	if(role->priority > 0){
+		param.sched_priority = role->priority;
+		if(sched_setscheduler(0, SCHED_FIFO, &param) < 0)
+			printf("DEBUG: %s priority not set\n", role->name);
+	}
+
+	if(role->cpu >= 0){
+		CPU_ZERO(&set);
+		CPU_SET(role->cpu, &set);
+		if(sched_setaffinity(0, sizeof(set), &set) < 0)
+			printf("DEBUG: %s affinity not set\n", role->name);
+	}
+}
+
+static int role_run(struct role *role){
+	role_setup(role);
+	return role->run();
+}
+
+// print context switches, memory and keypress-to-display latency
+static void print_bench(void){
+	struct rusage self, children;
+	unsigned int *hist, count;
+
+	getrusage(RUSAGE_SELF, &self);
+	getrusage(RUSAGE_CHILDREN, &children);
+
+	printf("DEBUG: context switches %ld voluntary %ld involuntary\n",
+			self.ru_nvcsw + children.ru_nvcsw,
+			self.ru_nivcsw + children.ru_nivcsw);
+	printf("DEBUG: max rss %ldKB (children %ldKB)\n",
+			self.ru_maxrss, children.ru_maxrss);
+	print_latency("keypress-to-display", bench_shm->hist, bench_shm->count);
+
+	hist = dev_latency('1', &count);
+	print_latency("stop watch event-to-display", hist, count);
+	hist = dev_latency('2', &count);
+	print_latency("text editor event-to-display", hist, count);
+	hist = dev_latency('3', &count);
+	print_latency("custom event-to-display", hist, count);
+}
+
+// options: -r refresh rate (Hz), -p refresh priority, -c refresh cpu,
+//          -b brightness of digits (%, one value or comma separated), -k blanking (us),
+//          -R record input to file, -P replay input of file on simulated devices,
+//          -x replay speed (times faster than recorded), -d T9 dictionary file,
+//          -f dot matrix animation frames per second
+// runtime: signal any process of the program (its pid is printed at start, or
+//          attach shared memory 5555 and bump generation after changing struct tune)
+//          SIGUSR1 / SIGUSR2 brightness of every digit, SIGRTMIN / SIGRTMIN+1 blanking
+static void parse_options(int argc, char *argv[]){
+	char *s;
+	int i, opt;
+
+	while((opt = getopt(argc, argv, "r:p:c:b:k:R:P:x:d:f:")) != -1){
+		switch(opt){
+			case 'r':
+				refresh_rate = atoi(optarg);
+				break;
+			case 'p':
+				refresh_priority = atoi(optarg);
+				break;
+			case 'c':
+				refresh_cpu = atoi(optarg);
+				break;
+			case 'b':
+				s = optarg;
+				for(i=0;i<FND_DIGITS;i++){
+					fnd_duty[i] = atoi(s);
+					if(fnd_duty[i] > 100)
+						fnd_duty[i] = 100;
+					if(fnd_duty[i] < 0)
+						fnd_duty[i] = 0;
+					if(strchr(s, ',') != NULL)
+						s = strchr(s, ',') + 1;
+				}
+				break;
+			case 'k':
+				fnd_blank = atoi(optarg);
+				break;
+			case 'R':
+				record_path = optarg;
+				break;
+			case 'P':
+				replay_path = optarg;
+				break;
+			case 'x':
+				replay_speed = atoi(optarg);
+				break;
+			case 'd':
+				t9_path = optarg;
+				break;
+			case 'f':
+				anim_fps = atoi(optarg);
+				break;
+			default:
+				printf("usage: %s [-r refresh_hz] [-p priority] [-c cpu] [-b duty[,duty...]] [-k blank_us]"
+						" [-R record] [-P replay] [-x speed] [-d dict] [-f fps]\n", argv[0]);
+				exit(1);
+		}
+	}
+
+	if(refresh_rate < 1)
+		refresh_rate = 1;
+	if(fnd_blank < 0)
+		fnd_blank = 0;
+	if(anim_fps < 1)
+		anim_fps = 1;
+}
+
+#ifdef THREADED
+static void *role_thread(void *arg){
+	role_run(arg);
+	return NULL;
+}
+
+int main(int argc, char *argv[]){
+	pthread_t thread[sizeof(roles) / sizeof(roles[0])];
+	pthread_attr_t attr;
+	int i, n = sizeof(roles) / sizeof(roles[0]);
+
+	parse_options(argc, argv);
+
+	// shared state is plain memory of this process
+	shared_memory();
+
+	// device backend is shared by roles started after this
+	if(dev_init(record_path, replay_path, replay_speed) < 0)
+		die("device backend");
+
+	thread_attr(&attr);
+	for(i=0;i<n;i++)
+		if(pthread_create(&thread[i], &attr, role_thread, &roles[i]) != 0)
+			die("thread creation failed");
+	pthread_attr_destroy(&attr);
+	dev_replay();
+
+	// every role ends on quit key
+	for(i=0;i<n;i++)
+		pthread_join(thread[i], NULL);
+
+	print_bench();
+	free_shared();
+
+	return 0;
+}
+#else
 int main(int argc, char *argv[]){
 	pid_t pid;
+	int ret;
+
+	parse_options(argc, argv);
 
 	// initialize shared memory for IPCs
 	shared_memory();
 
+	// device backend is shared by roles forked after this
+	if(dev_init(record_path, replay_path, replay_speed) < 0)
+		die("device backend");
+
 	pid = fork();
 	switch(pid){
 		case -1:
@@ -929,10 +1791,12 @@ int main(int argc, char *argv[]){
 					die("process creation failed");
 				case 0:
 					// event key process (input)
-					return eventkey_process();
+					return role_run(&roles[0]);
 				default:
 					// input process
-					return input_process();
+					ret = role_run(&roles[1]);
+					while(wait(NULL) > 0);
+					return ret;
 			}
 		default:
 			pid = fork();
@@ -942,14 +1806,20 @@ int main(int argc, char *argv[]){
 					die("process creation failed");
 				case 0:
 					// output process
-					return output_process();
+					return role_run(&roles[2]);
 				default:
-					// main process
-					main_process();
+					// main process (replays recorded input if any)
+					dev_replay();
+					role_run(&roles[3]);
 			}
 	}
 
+	// every role ends on quit key
+	while(wait(NULL) > 0);
+
+	print_bench();
 	free_shared();
 
 	return 0;
 }
+#endif
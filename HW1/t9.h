@@ -0,0 +1,66 @@
+/* T9 predictive dictionary of 20091648
+   trie over key sequences, built by t9gen and memory-mapped as is,
+   each node holds its most frequent words so a key press is one lookup */
+
+#ifndef __T9_H__
+#define __T9_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define T9_MAGIC 0x32443954	// "T9D2"
+#define T9_KEYS 9		// push switch 1 ~ 9
+#define T9_CAND 4		// candidates kept per node (by frequency)
+#define T9_WORD 32		// longest word (one lcd screen)
+#define T9_NONE 0xFFFFFFFF
+
+// file layout : header, nodes (breadth first, root is 0), candidate table, string pool
+struct t9_header{
+	uint32_t magic;
+	uint32_t nodes;
+	uint32_t cands;		// entries of candidate table
+	uint32_t strings;	// offset of string pool
+	uint32_t size;		// file size
+};
+
+// children of a node are consecutive (breadth first), the child of a key
+// is first child + number of keys below it with a child
+struct t9_node{
+	uint16_t keys;		// bit per key with a child
+	uint16_t cands;		// words of exactly this key sequence (most frequent first)
+	uint32_t child;		// index of first child
+	uint32_t cand;		// first of its words in candidate table
+	uint32_t best;		// most frequent word below this node
+};
+
+struct t9_dict{
+	const struct t9_header *head;
+	const struct t9_node *node;
+	const uint32_t *cand;	// string pool offset of each candidate
+	const char *str;
+	uint32_t str_size;
+};
+
+// word being typed
+struct t9_state{
+	int len;
+	int cand;			// candidate shown
+	uint32_t node[T9_WORD + 1];	// node after each key (T9_NONE off trie)
+	unsigned char keys[T9_WORD];
+};
+
+// letters of each key ('.' has no word)
+extern const char t9_letters[T9_KEYS][4];
+
+int t9_open(struct t9_dict *dict, const char *path);
+void t9_close(struct t9_dict *dict);
+
+void t9_reset(struct t9_state *st);
+int t9_key(const struct t9_dict *dict, struct t9_state *st, int key);
+int t9_back(const struct t9_dict *dict, struct t9_state *st);
+int t9_next(const struct t9_dict *dict, struct t9_state *st);
+
+// letters shown for current key sequence (st->len characters)
+int t9_text(const struct t9_dict *dict, const struct t9_state *st, char *out);
+
+#endif
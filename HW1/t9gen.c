@@ -0,0 +1,321 @@
+/* T9 dictionary compiler and benchmark (runs on build host or board)
+   t9gen build words.txt t9.dict	word list -> trie file
+   t9gen bench t9.dict words.txt	startup, rss and per key latency
+
+   word list has one word per line, optionally followed by frequency.
+   without frequency, earlier words rank higher (frequency sorted lists) */
+
+#include <sys/resource.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "./t9.h"
+
+#define NODE_INIT 4096
+#define POOL_INIT 65536
+#define LINE_BUFF 256
+
+// trie node while building (candidates with frequency)
+struct build_node{
+	uint32_t child[T9_KEYS];
+	uint32_t cand[T9_CAND];
+	long freq[T9_CAND];
+	uint32_t best;
+	long best_freq;
+};
+
+static struct build_node *nodes;
+static int node_count, node_size;
+static char *pool;
+static int pool_len, pool_size;
+static int key_of[26];		// letter -> key
+
+static long long now_ns(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint32_t new_node(void){
+	int i;
+
+	if(node_count == node_size){
+		node_size = node_size ? node_size * 2 : NODE_INIT;
+		if((nodes = realloc(nodes, sizeof(struct build_node) * node_size)) == NULL){
+			perror("realloc");
+			exit(1);
+		}
+	}
+
+	for(i=0;i<T9_KEYS;i++)
+		nodes[node_count].child[i] = T9_NONE;
+	for(i=0;i<T9_CAND;i++){
+		nodes[node_count].cand[i] = T9_NONE;
+		nodes[node_count].freq[i] = 0;
+	}
+	nodes[node_count].best = T9_NONE;
+	nodes[node_count].best_freq = 0;
+
+	return node_count++;
+}
+
+static uint32_t add_string(const char *word, int len){
+	uint32_t off;
+
+	while(pool_len + len + 1 > pool_size){
+		pool_size = pool_size ? pool_size * 2 : POOL_INIT;
+		if((pool = realloc(pool, pool_size)) == NULL){
+			perror("realloc");
+			exit(1);
+		}
+	}
+
+	off = pool_len;
+	memcpy(pool + pool_len, word, len);
+	pool[pool_len + len] = '\0';
+	pool_len += len + 1;
+
+	return off;
+}
+
+// keep T9_CAND most frequent words of node
+static void add_cand(struct build_node *n, uint32_t word, long freq){
+	int i, j;
+
+	for(i=0;i<T9_CAND;i++)
+		if(n->cand[i] == T9_NONE || freq > n->freq[i])
+			break;
+	if(i == T9_CAND)
+		return;
+
+	for(j=T9_CAND-1;j>i;j--){
+		n->cand[j] = n->cand[j-1];
+		n->freq[j] = n->freq[j-1];
+	}
+	n->cand[i] = word;
+	n->freq[i] = freq;
+}
+
+static void add_word(const char *word, int len, long freq){
+	uint32_t node = 0, next, str;
+	int i, key;
+
+	str = add_string(word, len);
+
+	for(i=0;i<len;i++){
+		key = key_of[word[i] - 'a'];
+		if((next = nodes[node].child[key]) == T9_NONE){
+			next = new_node();
+			nodes[node].child[key] = next;
+		}
+		node = next;
+
+		// every prefix node remembers its best completion
+		if(nodes[node].best == T9_NONE || freq > nodes[node].best_freq){
+			nodes[node].best = str;
+			nodes[node].best_freq = freq;
+		}
+	}
+
+	add_cand(&nodes[node], str, freq);
+}
+
+// read word list, skip words with letters outside a ~ z
+static int load_words(const char *path){
+	FILE *fp;
+	char line[LINE_BUFF], word[LINE_BUFF];
+	long freq, rank = 0;
+	int i, len, n, count = 0;
+
+	if((fp = fopen(path, "r")) == NULL){
+		perror(path);
+		return -1;
+	}
+
+	while(fgets(line, sizeof(line), fp) != NULL){
+		n = sscanf(line, "%255s %ld", word, &freq);
+		if(n < 1)
+			continue;
+		if(n < 2)
+			freq = -rank;
+		rank++;
+
+		len = strlen(word);
+		if(len > T9_WORD)
+			continue;
+		for(i=0;i<len;i++){
+			word[i] = tolower((unsigned char)word[i]);
+			if(word[i] < 'a' || word[i] > 'z')
+				break;
+		}
+		if(i < len)
+			continue;
+
+		add_word(word, len, freq);
+		count++;
+	}
+	fclose(fp);
+
+	return count;
+}
+
+// write nodes in breadth first order so upper levels share cache lines
+static int build(const char *words, const char *out){
+	struct t9_header head;
+	struct t9_node node;
+	uint32_t *order, *index, cands = 0;
+	FILE *fp;
+	int i, k, head_pos, tail_pos, count;
+
+	for(i=0;i<T9_KEYS;i++)
+		for(k=0;t9_letters[i][k]!='\0';k++)
+			if(t9_letters[i][k] >= 'a' && t9_letters[i][k] <= 'z')
+				key_of[t9_letters[i][k] - 'a'] = i;
+
+	new_node();
+	if((count = load_words(words)) < 0)
+		return -1;
+
+	order = malloc(sizeof(uint32_t) * node_count);
+	index = malloc(sizeof(uint32_t) * node_count);
+	if(order == NULL || index == NULL)
+		return -1;
+
+	order[0] = 0;
+	for(head_pos=0, tail_pos=1;head_pos<tail_pos;head_pos++){
+		index[order[head_pos]] = head_pos;
+		for(k=0;k<T9_KEYS;k++)
+			if(nodes[order[head_pos]].child[k] != T9_NONE)
+				order[tail_pos++] = nodes[order[head_pos]].child[k];
+	}
+
+	for(i=0;i<node_count;i++)
+		for(k=0;k<T9_CAND && nodes[i].cand[k]!=T9_NONE;k++)
+			cands++;
+
+	head.magic = T9_MAGIC;
+	head.nodes = node_count;
+	head.cands = cands;
+	head.strings = sizeof(head) + sizeof(struct t9_node) * node_count + sizeof(uint32_t) * cands;
+	head.size = head.strings + pool_len;
+
+	if((fp = fopen(out, "wb")) == NULL){
+		perror(out);
+		return -1;
+	}
+	fwrite(&head, sizeof(head), 1, fp);
+
+	// children were queued together, first one in key order is lowest index
+	for(i=0,cands=0;i<node_count;i++){
+		struct build_node *b = &nodes[order[i]];
+
+		memset(&node, 0, sizeof(node));
+		node.child = T9_NONE;
+		for(k=T9_KEYS-1;k>=0;k--)
+			if(b->child[k] != T9_NONE){
+				node.keys |= 1 << k;
+				node.child = index[b->child[k]];
+			}
+		node.cand = cands;
+		while(node.cands < T9_CAND && b->cand[node.cands] != T9_NONE)
+			node.cands++;
+		cands += node.cands;
+		node.best = b->best;
+		fwrite(&node, sizeof(node), 1, fp);
+	}
+
+	// candidate table in node order
+	for(i=0;i<node_count;i++)
+		for(k=0;k<T9_CAND && nodes[order[i]].cand[k]!=T9_NONE;k++)
+			fwrite(&nodes[order[i]].cand[k], sizeof(uint32_t), 1, fp);
+	fwrite(pool, 1, pool_len, fp);
+	fclose(fp);
+
+	printf("%d words, %d nodes, %u bytes\n", count, node_count, head.size);
+	return 0;
+}
+
+// type every word of list key by key and time each key
+static int bench(const char *dict_path, const char *words){
+	struct t9_dict dict;
+	struct t9_state st;
+	struct rusage ru;
+	FILE *fp;
+	char line[LINE_BUFF], word[LINE_BUFF], out[T9_WORD];
+	long long start, keys = 0, total = 0, t, max = 0;
+	int i, len, hit = 0, count = 0;
+
+	start = now_ns();
+	if(t9_open(&dict, dict_path) < 0){
+		printf("%s open error\n", dict_path);
+		return -1;
+	}
+	printf("startup %lldus, %u nodes\n", (now_ns() - start) / 1000, dict.head->nodes);
+
+	for(i=0;i<T9_KEYS;i++)
+		for(len=0;t9_letters[i][len]!='\0';len++)
+			if(t9_letters[i][len] >= 'a' && t9_letters[i][len] <= 'z')
+				key_of[t9_letters[i][len] - 'a'] = i;
+
+	if((fp = fopen(words, "r")) == NULL){
+		perror(words);
+		return -1;
+	}
+
+	while(fgets(line, sizeof(line), fp) != NULL){
+		if(sscanf(line, "%255s", word) < 1)
+			continue;
+		len = strlen(word);
+		if(len > T9_WORD)
+			continue;
+		for(i=0;i<len;i++){
+			word[i] = tolower((unsigned char)word[i]);
+			if(word[i] < 'a' || word[i] > 'z')
+				break;
+		}
+		if(i < len)
+			continue;
+
+		t9_reset(&st);
+		for(i=0;i<len;i++){
+			start = now_ns();
+			t9_key(&dict, &st, key_of[word[i] - 'a']);
+			t9_text(&dict, &st, out);
+			t = now_ns() - start;
+
+			total += t;
+			if(t > max)
+				max = t;
+			keys++;
+		}
+
+		// word is first candidate (no extra press needed)
+		if(memcmp(out, word, len) == 0)
+			hit++;
+		count++;
+	}
+	fclose(fp);
+
+	getrusage(RUSAGE_SELF, &ru);
+	printf("%d words, %lld keys, avg %lldns max %lldns per key\n",
+			count, keys, keys ? total / keys : 0, max);
+	printf("first candidate hit %d%%, max rss %ldKB\n",
+			count ? hit * 100 / count : 0, ru.ru_maxrss);
+
+	t9_close(&dict);
+	return 0;
+}
+
+int main(int argc, char *argv[]){
+	if(argc == 4 && strcmp(argv[1], "build") == 0)
+		return build(argv[2], argv[3]) < 0;
+	if(argc == 4 && strcmp(argv[1], "bench") == 0)
+		return bench(argv[2], argv[3]) < 0;
+
+	printf("usage: %s build words.txt t9.dict\n", argv[0]);
+	printf("       %s bench t9.dict words.txt\n", argv[0]);
+	return 1;
+}
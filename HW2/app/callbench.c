@@ -0,0 +1,86 @@
+#include <unistd.h>
+#include <syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#define SYS_RETURNCALL 366
+#define SYS_RETURNCALLV 367	// batched, one kernel entry for many commands
+#define MAX_COMMANDS 1024
+
+// same layout as struct mydata of kernel
+struct command{
+	int time;
+	int num;
+	char option[4];
+};
+
+static long long now_ns(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// cost per command of count single calls against one batched call
+int main(int argc, char *argv[]){
+	static struct command cmd[MAX_COMMANDS];
+	static long single[MAX_COMMANDS], batch[MAX_COMMANDS];
+	long long start, single_ns = 0, batch_ns = 0;
+	int count = 64, rounds = 1000;
+	int i, r, bad = 0;
+	long done;
+
+	if(argc > 1)
+		count = atoi(argv[1]);
+	if(argc > 2)
+		rounds = atoi(argv[2]);
+	if(count < 1 || count > MAX_COMMANDS || rounds < 1){
+		printf("usage: %s [commands(1-%d)] [rounds]\n", argv[0], MAX_COMMANDS);
+		return -1;
+	}
+
+	// figure 1 ~ 8 walks over 4 positions, last command is invalid on purpose
+	for(i=0;i<count;i++){
+		cmd[i].time = i % 100 + 1;
+		cmd[i].num = (i * 7) % 100 + 1;
+		memcpy(cmd[i].option, "0000", 4);
+		cmd[i].option[i % 4] = '1' + i % 8;
+	}
+	if(count > 1)
+		memcpy(cmd[count-1].option, "1200", 4);
+
+	for(r=0;r<rounds;r++){
+		start = now_ns();
+		for(i=0;i<count;i++)
+			single[i] = syscall(SYS_RETURNCALL, &cmd[i]);
+		single_ns += now_ns() - start;
+
+		start = now_ns();
+		done = syscall(SYS_RETURNCALLV, cmd, batch, count);
+		batch_ns += now_ns() - start;
+
+		if(done != count){
+			printf("returncallv error : %ld (%s)\n", done, strerror(errno));
+			return -1;
+		}
+	}
+
+	// batched result matches single call, invalid entry fails alone
+	for(i=0;i<count;i++){
+		if(batch[i] < 0)
+			printf("command %d (%d %d %.4s) : %s\n", i, cmd[i].time, cmd[i].num, cmd[i].option, strerror(-batch[i]));
+		else if(batch[i] != single[i])
+			bad++;
+	}
+
+	printf("%d commands x %d rounds\n", count, rounds);
+	printf("returncall  : %lld ns per command\n", single_ns / ((long long)count * rounds));
+	printf("returncallv : %lld ns per command\n", batch_ns / ((long long)count * rounds));
+	if(bad)
+		printf("%d batched results differ from single call\n", bad);
+
+	return bad ? -1 : 0;
+}
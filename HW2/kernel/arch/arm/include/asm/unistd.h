@@ -393,6 +393,7 @@
 #define __NR_perf_event_open		(__NR_SYSCALL_BASE+364)
 #define __NR_recvmmsg			(__NR_SYSCALL_BASE+365)
 #define __NR_returncall			(__NR_SYSCALL_BASE+366)
+#define __NR_returncallv		(__NR_SYSCALL_BASE+367)
 
 /*
  * The following SWIs are ARM private.
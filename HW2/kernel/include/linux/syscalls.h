@@ -827,5 +827,6 @@ asmlinkage long sys_mmap_pgoff(unsigned long addr, unsigned long len,
 			unsigned long fd, unsigned long pgoff);
 asmlinkage long sys_old_mmap(struct mmap_arg_struct __user *arg);
 asmlinkage long sys_returncall(struct mydata *);
+asmlinkage long sys_returncallv(struct mydata *, long *, unsigned int);
 
 #endif
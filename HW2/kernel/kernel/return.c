@@ -1,41 +1,41 @@
 #include <linux/kernel.h>
+#include <linux/errno.h>
 #include <asm/uaccess.h>
 
+#define RETURNCALL_CHUNK 16	// commands copied from user space at once
+
 struct mydata{
 	int time;
 	int num;
 	char option[4];
 };
 
-asmlinkage long sys_returncall(struct mydata *data){
-	struct mydata input;
+// 4 byte stream (position, value, time, num) of one command
+static long returncall_encode(const struct mydata *input){
 	char position, value, time, num;
 	long result = 0;
 
-	// copy user space data to kernel space	
-	copy_from_user(&input, data, sizeof(input));
-
 	// distinguish user option (position & start value)
-	if(input.option[0] != '0'){
+	if(input->option[0] != '0'){
 		position = '1';
-		value = input.option[0];
+		value = input->option[0];
 	}
-	else if(input.option[1] != '0'){
+	else if(input->option[1] != '0'){
 		position = '2';
-		value = input.option[1];
+		value = input->option[1];
 	}
-	else if(input.option[2] != '0'){
+	else if(input->option[2] != '0'){
 		position = '3';
-		value = input.option[2];
+		value = input->option[2];
 	}
 	else{
 		position = '4';
-		value = input.option[3];
+		value = input->option[3];
 	}
 
 	// store data to variable from user space
-	time = input.time;
-	num = input.num;
+	time = input->time;
+	num = input->num;
 
 	// shift characters to proper place of 4 byte stream
 	result += position<<24;
@@ -43,6 +43,59 @@ asmlinkage long sys_returncall(struct mydata *data){
 	result += time<<8;
 	result += num;
 	// 4byte stream (position , value , time , num)
-	
+
 	return result;
 }
+
+// same limits as the application, one figure 1 ~ 8 and zeroes elsewhere
+static int returncall_check(const struct mydata *input){
+	int i, figures = 0;
+
+	if(input->time < 0 || input->time > 100 || input->num < 0 || input->num > 100)
+		return -EINVAL;
+
+	for(i=0;i<4;i++){
+		if(input->option[i] < '0' || input->option[i] > '8')
+			return -EINVAL;
+		if(input->option[i] != '0')
+			figures++;
+	}
+
+	return figures == 1 ? 0 : -EINVAL;
+}
+
+asmlinkage long sys_returncall(struct mydata *data){
+	struct mydata input;
+
+	// copy user space data to kernel space
+	if(copy_from_user(&input, data, sizeof(input)))
+		return -EFAULT;
+
+	return returncall_encode(&input);
+}
+
+// encode count commands in one kernel entry, results[i] is the stream of
+// data[i] or negative errno of that command, returns number of commands done
+asmlinkage long sys_returncallv(struct mydata *data, long *results, unsigned int count){
+	struct mydata input[RETURNCALL_CHUNK];
+	long result[RETURNCALL_CHUNK];
+	unsigned int done, n, i;
+
+	for(done=0;done<count;done+=n){
+		n = count - done < RETURNCALL_CHUNK ? count - done : RETURNCALL_CHUNK;
+
+		if(copy_from_user(input, data + done, n * sizeof(input[0])))
+			return done ? done : -EFAULT;
+
+		for(i=0;i<n;i++){
+			result[i] = returncall_check(&input[i]);
+			if(result[i] == 0)
+				result[i] = returncall_encode(&input[i]);
+		}
+
+		if(copy_to_user(results + done, result, n * sizeof(result[0])))
+			return done ? done : -EFAULT;
+	}
+
+	return done;
+}
@@ -4,6 +4,9 @@
   Made by Lee Jun-Ho (dangercloz@gmail.com)
  ********************************************/
 
+#ifdef SIM
+#include "sim.h"	// host build of sim/, mock kernel and board
+#else
 #include <linux/module.h>
 #include <linux/fs.h>
 #include <linux/init.h>
@@ -14,15 +17,26 @@
 #include <linux/platform_device.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/seqlock.h>
 
 #include <asm/io.h>
+#include <asm/atomic.h>
 #include <asm/uaccess.h>
 #include <asm/ioctl.h>
 #include <mach/gpio.h>
 #include <mach/regs-gpio.h>
 #include <plat/gpio-cfg.h>
 
-#include "./fpga_dot_font.h"
+// later kernels name ACCESS_ONCE of seqlock sections like this
+#ifndef READ_ONCE
+#define READ_ONCE(x) ACCESS_ONCE(x)
+#define WRITE_ONCE(x, v) (ACCESS_ONCE(x) = (v))
+#endif
+#endif
+
+#include "./dot_font.h"
 
 #define DEV_MAJOR 242	// dev driver major number
 #define DEV_MINOR 0	// dev driver minor number
@@ -46,6 +60,8 @@
 #define FND_GPE3CON 0x11400140	// fnd pin configuration
 #define FND_GPE3DAT 0x11400144	// fnd pin data
 
+#define FND_PWM_SLOTS 2	// lit and blank slot of fnd pwm
+
 // led driver device address
 #define LED_GPBCON 0x11400040	// GPBCON register physical addr
 #define LED_GPBDAT 0x11400044	// GPBDAT register physical addr
@@ -71,7 +87,7 @@ int fpga_text_calculate(int);
 ssize_t fpga_text_write(const char *);
 
 // Global variable
-static int dev_usage = 0;
+static atomic_t dev_usage = ATOMIC_INIT(0);
 static unsigned char *iom_demo_addr;
 
 // fnd global variable
@@ -80,6 +96,27 @@ static unsigned int *fnd_ctrl;
 static unsigned char *fnd_data2;
 static unsigned int *fnd_ctrl2;
 
+// fnd brightness (pwm of digit select)
+static int fnd_duty = 100;
+module_param(fnd_duty, int, 0644);
+MODULE_PARM_DESC(fnd_duty, "FND lit time in percent");
+static int fnd_pwm_hz = 500;
+module_param(fnd_pwm_hz, int, 0644);
+MODULE_PARM_DESC(fnd_pwm_hz, "FND pwm frequency in Hz");
+
+// one timing slot of fnd pwm
+struct fnd_slot{
+	int lit;	// digit selected or blanked
+	ktime_t len;	// length of slot
+};
+
+// fnd pwm global variable
+static struct hrtimer fnd_pwm;
+static struct fnd_slot fnd_table[FND_PWM_SLOTS];
+static int fnd_slots, fnd_slot;
+static int table_duty, table_hz;	// parameters table was built from
+static unsigned char fnd_sel_cur;	// selected digit (0 for off)
+
 // led global variable
 static char *led_buffer = NULL;
 static unsigned char *led_data;
@@ -91,6 +128,11 @@ static unsigned char *iom_fpga_led_addr;	// addr of fpga led
 static unsigned char *iom_fpga_dot_addr;	// addr of fpga dot
 static unsigned char *iom_fpga_text_lcd_addr;	// addr of fpga text lcd
 
+// fpga text lcd shadow, only changed cells are written
+static unsigned char text_shown[32];
+static int text_valid = 0;		// shadow matches lcd
+static unsigned int text_cells, text_skipped;
+
 static struct file_operations dev_fops =
 {
 	.open = dev_open,
@@ -99,7 +141,7 @@ static struct file_operations dev_fops =
 	.read = dev_read,
 };
 
-static struct struct_timer{
+struct struct_timer{
 	struct timer_list timer;
 	int count;	// start from 0
 	int end_count;	// expire count
@@ -114,19 +156,21 @@ static struct struct_timer{
 // timer global variable
 struct struct_timer mytimer;
 
-// open device driver
+// count, end_count and data of mytimer change under this lock,
+// dev_read takes a snapshot without blocking the timer
+static DEFINE_SEQLOCK(timer_lock);
+
+// open device driver, only one user on any cpu
 int dev_open(struct inode *minode, struct file *mfile){
-	if(dev_usage != 0)
+	if(atomic_cmpxchg(&dev_usage, 0, 1) != 0)
 		return -EBUSY;
 
-	dev_usage = 1;
-
 	return 0;
 }
 
 // release device driver
 int dev_release(struct inode *minode, struct file *mfile){
-	dev_usage = 0;
+	atomic_set(&dev_usage, 0);
 
 	return 0;
 }
@@ -145,56 +189,111 @@ int close_devices(){
 }
 
 static void kernel_timer_blink(unsigned long timeout){
-	struct struct_timer *p_data = (struct sturct_timer *)timeout;
+	struct struct_timer *p_data = (struct struct_timer *)timeout;
 	char position, value;
-	unsigned short temp_value;
-
-	p_data->count++;	// increase count
+	unsigned short temp_value, data;
+	int count = p_data->count + 1;	// this tick, published below
 
 	// pass data to send as parameter
 	position = (char)(p_data->data>>8);
 	value = (char)(p_data->data&0x00FF);
 
 	// pass data to fpga devices
-	fpga_fnd_write(p_data->end_count - p_data->count + 1);
+	fpga_fnd_write(p_data->end_count - count + 1);
 	fpga_dot_write(value);
 	fpga_led_write(value);
 	fpga_text_calculate(1);
 
 	// pass data to gpio device
 	led_write(position);
-	p_data->data = fnd_write(p_data->data);
+	temp_value = fnd_write(p_data->data);
+
+	// next data, last tick keeps what was shown
+	data = p_data->data;
+	if(count <= p_data->end_count){
+		// decode changed data to store
+		position = (char)(temp_value>>8);
+		value = (char)(temp_value&0x00FF);
+
+		// change value if maximum value is reached
+		if(value >56){ // change value to 1 if value is over 8
+			value = 49;
+			position += 1;	// increase position
+
+			// change position if it reaches at the end
+			if(position > 52)
+				position = 49;
+		}
+		data = position;		// new position
+		data = (data<<8)|value;		// new value
+	}
+
+	// count and data change together, a reader never sees half a tick
+	write_seqlock(&timer_lock);
+	WRITE_ONCE(p_data->count, count);
+	WRITE_ONCE(p_data->data, data);
+	write_sequnlock(&timer_lock);
 
 	// check if count has reached limit
-	if(p_data->count > p_data->end_count){
+	if(count > p_data->end_count){
 		close_devices();
 		return;
 	}
 
-	// decode changed data to store
-	temp_value = p_data->data;
-	position = (char)(temp_value>>8);
-	value = (char)(temp_value&0x00FF);
+	mytimer.timer.expires = get_jiffies_64() + (p_data->time * HZ)/10;
+	mytimer.timer.data = (unsigned long)&mytimer;
+	mytimer.timer.function = kernel_timer_blink;
 
-	// change value if maximum value is reached
-	if(value >56){ // change value to 1 if value is over 8
-		value = 49;
-		position += 1;	// increase position
+	add_timer(&mytimer.timer);
+}
 
-		// change position if it reaches at the end
-		if(position > 52)
-			position = 49;
+// precompute pwm slots, digit is lit for duty then blanked
+static void fnd_pwm_table(void){
+	unsigned long period, lit;
+	int n = 0;
+
+	if(fnd_duty < 0)
+		fnd_duty = 0;
+	if(fnd_duty > 100)
+		fnd_duty = 100;
+	if(fnd_pwm_hz < 1)
+		fnd_pwm_hz = 1;
+	table_duty = fnd_duty;
+	table_hz = fnd_pwm_hz;
+
+	period = NSEC_PER_SEC / fnd_pwm_hz;
+	lit = period / 100 * fnd_duty;
+	if(lit > 0){
+		fnd_table[n].lit = 1;
+		fnd_table[n++].len = ktime_set(0, lit);
+	}
+	if(period - lit > 0){
+		fnd_table[n].lit = 0;
+		fnd_table[n++].len = ktime_set(0, period - lit);
 	}
+	fnd_slots = n;
+}
 
-	// set modified timer data
-	mytimer.data = position;		// new position
-	mytimer.data = (mytimer.data<<8)|value;	// new value
+// run one slot of fnd pwm (hrtimer interrupt context)
+static enum hrtimer_restart fnd_pwm_slot(struct hrtimer *timer){
+	struct fnd_slot *p;
 
-	mytimer.timer.expires = get_jiffies_64() + (p_data->time * HZ)/10;
-	mytimer.timer.data = (unsigned long)&mytimer;
-	mytimer.timer.function = kernel_timer_blink;
+	// parameters changed, rebuild table at end of period
+	if(fnd_slot == 0 && (fnd_duty != table_duty || fnd_pwm_hz != table_hz))
+		fnd_pwm_table();
+	p = &fnd_table[fnd_slot];
+	fnd_slot = (fnd_slot + 1) % fnd_slots;
 
-	add_timer(&mytimer.timer);
+	outb(p->lit ? fnd_sel_cur : 0x00, (unsigned int)fnd_data2);
+
+	// no pwm needed when fnd is off or at full brightness
+	if(fnd_sel_cur == 0 || table_duty == 100){
+		outb(fnd_sel_cur, (unsigned int)fnd_data2);
+		return HRTIMER_NORESTART;
+	}
+
+	hrtimer_forward_now(timer, p->len);
+	return HRTIMER_RESTART;
 }
 
 unsigned short fnd_write(const unsigned short *gdata){
@@ -259,9 +358,19 @@ unsigned short fnd_write(const unsigned short *gdata){
 	fnd_buff = fnd_sel;
 	fnd_buff = (fnd_buff<<8)|fnd_dat;
 
-	// print data to device
-	outb(sel_bak, (unsigned int)fnd_data2);
+	// print data to device, blank before changing segments
+	// so new value does not ghost on previous digit
+	outb(0x00, (unsigned int)fnd_data2);
 	outb(dat_bak, (unsigned int)fnd_data);
+	outb(sel_bak, (unsigned int)fnd_data2);
+	fnd_sel_cur = sel_bak;
+
+	// dim digit by pwm of digit select
+	if(sel_bak != 0 && fnd_duty < 100 && !hrtimer_active(&fnd_pwm)){
+		fnd_slot = 0;
+		fnd_pwm_table();
+		hrtimer_start(&fnd_pwm, fnd_table[0].len, HRTIMER_MODE_REL);
+	}
 
 	return fnd_buff;
 }
@@ -339,7 +448,7 @@ ssize_t fpga_led_write(const char *gdata){
 ssize_t fpga_fnd_write(const int *gdata){
 	int i;
 	const int fnd_buff = gdata;
-	unsigned char value[4] = {0,};
+	char value[12];	// any int and terminator of sprintf
 
 	// change integer to string
 	sprintf(value, "%4d", fnd_buff);
@@ -352,47 +461,18 @@ ssize_t fpga_fnd_write(const int *gdata){
 }
 
 ssize_t fpga_dot_write(const char *gdata){
-	int i, num;
+	int i;
 	const char dot_buff = gdata;
-	unsigned char value[10] = {0,};
+	const unsigned char *value;
 
-	// copy fpga dot data to local char string
-	switch(dot_buff){
-		case '1':
-			num = 1;
-			break;
-		case '2':
-			num = 2;
-			break;
-		case '3':
-			num = 3;
-			break;
-		case '4':
-			num = 4;
-			break;
-		case '5':
-			num = 5;
-			break;
-		case '6':
-			num = 6;
-			break;
-		case '7':
-			num = 7;
-			break;
-		case '8':
-			num = 8;
-			break;
-		default: // fpga dot off
-			num = 0;
-			break;
-	}
-
-	// copy dot data to local string
-	for(i=0;i<10;i++)
-		value[i] = fpga_number[num][i];
+	// figure of option '1' ~ '8', others turn fpga dot off
+	if(dot_buff >= '1' && dot_buff <= '8')
+		value = dot_glyph(DOT_FIGURE0 + dot_buff - '0');
+	else
+		value = dot_glyph(DOT_FIGURE0);
 
 	// print current type of char on fpga dot device
-	for(i=0;i<10;i++)
+	for(i=0;i<DOT_FONT_ROWS;i++)
 		outb(value[i], (unsigned int)iom_fpga_dot_addr + i);
 
 	return 0;
@@ -413,7 +493,7 @@ int fpga_text_calculate(int flag){
 	}
 
 	// pass data to text lcd device
-	fpga_text_write(tmp);
+	fpga_text_write((char *)tmp);
 
 	if(flag == 1){	// if timer is running
 		if(mytimer.id_flag == 1){
@@ -453,12 +533,20 @@ int fpga_text_calculate(int flag){
 }
 
 ssize_t fpga_text_write(const char *gdata){
-	unsigned char *text_buff = gdata;
+	const unsigned char *text_buff = (const unsigned char *)gdata;
 	int i;
 
-	// print current data on fpga text lcd device
-	for(i=0;i<32;i++)
+	// print changed cells of current data on fpga text lcd device
+	for(i=0;i<32;i++){
+		if(text_valid && text_shown[i] == text_buff[i]){
+			text_skipped++;
+			continue;
+		}
+		text_shown[i] = text_buff[i];
 		outb(text_buff[i], (unsigned int)iom_fpga_text_lcd_addr + i);
+		text_cells++;
+	}
+	text_valid = 1;
 
 	return 0;
 }
@@ -467,6 +555,7 @@ ssize_t dev_write(struct file *inode, const long *gdata, size_t length, loff_t *
 	const long *tmp = gdata;
 	long kernel_timer_buff = 0;
 	char position, value;
+	unsigned short data;
 	int time, number, i;
 	unsigned char id[16] = "20091648        ";
 	unsigned char name[16] = "Lee Jun Ho      ";
@@ -483,12 +572,18 @@ ssize_t dev_write(struct file *inode, const long *gdata, size_t length, loff_t *
 	number = kernel_timer_buff<<24;		// number
 	number = number>>24;
 
+	// stop running timer first, it may be on the other cpu
+	del_timer_sync(&mytimer.timer);
+
 	// set timer data
-	mytimer.count = 0;
-	mytimer.end_count = number;		// set end time
+	data = position;			// encode data
+	data = (data<<8)|value;			// encode data
+	write_seqlock_bh(&timer_lock);
+	WRITE_ONCE(mytimer.count, 0);
+	WRITE_ONCE(mytimer.end_count, number);	// set end time
+	WRITE_ONCE(mytimer.data, data);
+	write_sequnlock_bh(&timer_lock);
 	mytimer.time = time;			// set time interval
-	mytimer.data = position;		// encode data
-	mytimer.data = (mytimer.data<<8)|value;	// encode data
 	for(i=0;i<16;i++){ // copy string
 		mytimer.id[i] = id[i];
 		mytimer.name[i] = name[i];
@@ -497,7 +592,6 @@ ssize_t dev_write(struct file *inode, const long *gdata, size_t length, loff_t *
 	mytimer.name_flag = 1;	// right direction to move
 
 	// add timer
-	del_timer_sync(&mytimer.timer);
 	mytimer.timer.data = (unsigned long)&mytimer;
 	mytimer.timer.function = kernel_timer_blink;
 	add_timer(&mytimer.timer);
@@ -505,7 +599,27 @@ ssize_t dev_write(struct file *inode, const long *gdata, size_t length, loff_t *
 	return length;
 }
 
+// steps left (0 when finished) and data of the same step, without blocking timer
 ssize_t dev_read(struct file *inode, char *gdata, size_t length, loff_t *off_what){
+	unsigned int seq;
+	int snapshot[2];
+
+	if(length < sizeof(int))
+		return -EINVAL;
+
+	do{
+		seq = read_seqbegin(&timer_lock);
+		snapshot[0] = READ_ONCE(mytimer.end_count) - READ_ONCE(mytimer.count);
+		snapshot[1] = READ_ONCE(mytimer.data);
+	}while(read_seqretry(&timer_lock, seq));
+	if(snapshot[0] < 0)
+		snapshot[0] = 0;
+
+	if(length > sizeof(snapshot))
+		length = sizeof(snapshot);
+	if(copy_to_user(gdata, snapshot, length))
+		return -EFAULT;
+
 	return length;
 }
 
@@ -545,6 +659,8 @@ int __init dev_init(void){
 	}
 	outb(0xFF, (unsigned int)fnd_data);
 	outb(0xFF, (unsigned int)fnd_data);
+	hrtimer_init(&fnd_pwm, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	fnd_pwm.function = fnd_pwm_slot;
 	/* FND driver initialization ended */
 
 	/* LED driver initialization begin */
@@ -568,6 +684,8 @@ int __init dev_init(void){
 		// get GPBCON data
 		get_ctrl_io = inl((unsigned int)led_ctrl);
 		led_dev = device_create(led_dev_class, NULL, MKDEV(DEV_MAJOR, LED_MINOR), NULL, DEV_NAME);
+		if(led_dev == NULL)	// error handler for failure
+			printk("LED device create : failed!\n");
 		led_buffer = (char *)kmalloc(1024, GFP_KERNEL);
 
 		if(led_buffer != NULL)
@@ -597,6 +715,8 @@ int __init dev_init(void){
 	struct device *kernel_timer_dev = NULL;
 
 	kernel_timer_dev = device_create(kernel_timer_dev_class, NULL, MKDEV(DEV_MAJOR, TIMER_MINOR), NULL, DEV_NAME);
+	if(kernel_timer_dev == NULL)	// error handler for failure
+		printk("TIMER device create : failed!\n");
 	init_timer(&(mytimer.timer));
 	/* TIMER driver initialization ended */
 
@@ -605,7 +725,11 @@ int __init dev_init(void){
 }
 
 void __exit dev_exit(void){
-	/* FND driver free */
+	/* TIMER driver free, before anything it writes or arms is gone */
+	del_timer_sync(&mytimer.timer);
+
+	/* FND driver free, pwm can no longer be armed by a tick */
+	hrtimer_cancel(&fnd_pwm);
 	outb(0xFF, (unsigned int)fnd_data);
 	iounmap(fnd_data);	iounmap(fnd_data2);
 	iounmap(fnd_ctrl);	iounmap(fnd_ctrl2);
@@ -619,11 +743,9 @@ void __exit dev_exit(void){
 	iounmap(iom_fpga_led_addr);	// LED
 	iounmap(iom_fpga_dot_addr);	// DOT
 	iounmap(iom_fpga_text_lcd_addr);	// TEXT
+	printk("fpga text lcd %u cells written, %u unchanged\n", text_cells, text_skipped);
 	iounmap(iom_demo_addr);	// FPGA common factor
 
-	/* TIMER driver free */
-	del_timer_sync(&mytimer.timer);
-
 	// unregister device driver
 	unregister_chrdev(DEV_MAJOR, DEV_NAME);
 	printk("dev driver module removed.\n");
@@ -1,32 +0,0 @@
-/* This file is FPGA-DOT MATRIX font file.
-   FILE : fpga_dot_font.h
-   AUTH : Hong, Sung-Hyun
-          Huins, Inc. */
-
-#ifndef __FPGA_NUMBER__
-#define __FPGA_NUMBER__
-
-unsigned char fpga_number[10][10] = {
-	{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00}, // 0
-	{0x7F,0x7F,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60}, // 1
-	{0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x7F,0x7F}, // 2
-	{0x7F,0x7F,0x60,0x60,0x7F,0x7F,0x60,0x60,0x60,0x60}, // 3
-	{0x03,0x03,0x03,0x03,0x7F,0x7F,0x03,0x03,0x7F,0x7F}, // 4
-	{0x7F,0x7F,0x60,0x60,0x7F,0x7F,0x60,0x60,0x7F,0x7F}, // 5
-	{0x7F,0x7F,0x03,0x03,0x7F,0x7F,0x03,0x03,0x7F,0x7F}, // 6
-	{0x7F,0x7F,0x63,0x63,0x7F,0x7F,0x60,0x60,0x7F,0x7F}, // 7
-	{0x7F,0x7F,0x03,0x03,0x7F,0x7F,0x63,0x63,0x7F,0x7F}, // 8
-	{0x3e,0x7f,0x63,0x63,0x7f,0x3f,0x03,0x03,0x03,0x03} // 9
-};
-
-unsigned char fpga_set_full[10] = {
-	// memset(array,0x7e,sizeof(array));
-	0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f
-};
-
-unsigned char fpga_set_blank[10] = {
-	// memset(array,0x00,sizeof(array));
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
-};
-
-#endif
@@ -1,14 +1,52 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "../module/stopwatch_page.h"
 
 #define DEV_NAME "/dev/stopwatch"
+#define WATCH_HZ 10		// readout rate of -w
+
+// print stopwatch from mapped state page, no system call to driver
+static void watch(void){
+	struct stopwatch_page *page;
+	struct timespec now;
+	long long elapsed;
+	unsigned int laps;
+	int dev;
+
+	dev = open(DEV_NAME, O_RDONLY);
+	if(dev < 0){
+		printf("Device open error : %s\n", DEV_NAME);
+		exit(1);
+	}
+	page = mmap(NULL, sizeof(*page), PROT_READ, MAP_SHARED, dev, 0);
+	if(page == MAP_FAILED){
+		printf("Device mmap error : %s\n", DEV_NAME);
+		exit(1);
+	}
+	close(dev);
+
+	while(1){
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		elapsed = stopwatch_elapsed(page, now.tv_sec * 1000000000LL + now.tv_nsec, &laps);
+		printf("\r%02lld:%02lld.%03lld lap %u ", elapsed / 60000000000LL % 60,
+				elapsed / 1000000000LL % 60, elapsed / 1000000LL % 1000, laps);
+		fflush(stdout);
+		usleep(1000000 / WATCH_HZ);
+	}
+}
 
 int main(int argc, char *argv[]){
 	int dev, ret;
 	unsigned int gdata = 0;
 
+	if(argc > 1 && strcmp(argv[1], "-w") == 0)
+		watch();
+
 	dev = open(DEV_NAME, O_WRONLY);
 	if(dev < 0){
 		printf("Device open error : %s\n", DEV_NAME);
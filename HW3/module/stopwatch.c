@@ -4,6 +4,9 @@
   Made by Lee Jun-Ho (dangercloz@gmail.com)
 *********************************************/
 
+#ifdef SIM
+#include "sim.h"	// host build of sim/, mock kernel and board
+#else
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/fs.h>
@@ -14,14 +17,29 @@
 #include <linux/version.h>
 #include <linux/interrupt.h>
 #include <linux/wait.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/spinlock.h>
 #include <mach/gpio.h>
 #include <mach/regs-gpio.h>
 #include <plat/gpio-cfg.h>
 #include <asm/io.h>
 #include <asm/uaccess.h>
 #include <asm/irq.h>
+#include <asm/atomic.h>
 #include <asm/gpio.h>
 
+// later kernels name ACCESS_ONCE of seq sections like this
+#ifndef READ_ONCE
+#define READ_ONCE(x) ACCESS_ONCE(x)
+#define WRITE_ONCE(x, v) (ACCESS_ONCE(x) = (v))
+#endif
+#endif
+
+#include "./stopwatch_page.h"
+
 #define DEV_NAME "stopwatch"	// stopwatch module name
 #define DEV_MAJOR 245		// stopwatch module major number
 
@@ -30,6 +48,10 @@
 #define FND_GPE3CON 0x11400140	// fnd pin configuration
 #define FND_GPE3DAT 0x11400144	// fnd pin data
 
+#define FND_DIGITS 4		// digits multiplexed by refresh timer
+#define JITTER_SLOT 16		// refresh jitter histogram (1us << slot)
+#define FND_SLOTS (FND_DIGITS * 2)	// lit and blank slot per digit
+
 wait_queue_head_t wq_write;
 DECLARE_WAIT_QUEUE_HEAD(wq_write);
 irqreturn_t inter_handler(int irq, void *dev_id, struct pt_regs *reg);
@@ -37,23 +59,25 @@ irqreturn_t inter_handler(int irq, void *dev_id, struct pt_regs *reg);
 int stopwatch_open(struct inode *, struct file *);
 int stopwatch_release(struct inode *, struct file *);
 ssize_t stopwatch_write(struct file *, const short *, size_t, loff_t *);
+int stopwatch_mmap(struct file *, struct vm_area_struct *);
 
 static struct file_operations stopwatch_fops =
 {
 	.owner = THIS_MODULE,
 	.open = stopwatch_open,
 	.write = stopwatch_write,
+	.mmap = stopwatch_mmap,
 	.release = stopwatch_release,
 };
 
-static struct struct_mydata{
+struct struct_mydata{
 	struct timer_list timer;
 	int count;
 };
 
 // Global variables
-static int stopwatch_usage = 0;
-static int quit_flag = 1;
+static atomic_t stopwatch_usage = ATOMIC_INIT(0);	// owner opened
+static atomic_t quit_flag = ATOMIC_INIT(1);	// 0 after SW6 held 3 seconds
 
 // gpio fnd global variables
 static unsigned char *fnd_data;
@@ -62,21 +86,74 @@ static unsigned char *fnd_data2;
 static unsigned int *fnd_ctrl2;
 
 // timer module global variable
-struct struct_mydata mydata;
 struct struct_mydata quit_timer;
 
-static void kernel_timer_blink(unsigned long timeout){
-	struct struct_mydata *p_data = (struct struct_mydata *)timeout;
+// stopwatch state, published to readers through mapped page
+static struct stopwatch_page *state;
+static DEFINE_SPINLOCK(state_lock);	// writers (interrupts, open)
+
+// fnd refresh rate (full scans per second)
+static int refresh_hz = 50;
+module_param(refresh_hz, int, 0644);
+MODULE_PARM_DESC(refresh_hz, "FND refresh rate in Hz");
+
+// fnd brightness of each digit and blanking between digits
+static int duty[FND_DIGITS] = {100, 100, 100, 100};
+module_param_array(duty, int, NULL, 0644);
+MODULE_PARM_DESC(duty, "FND lit time of each digit in percent");
+static int blank_us = 50;
+module_param(blank_us, int, 0644);
+MODULE_PARM_DESC(blank_us, "FND blanking before next digit in us");
+
+// one timing slot of fnd scan
+struct fnd_slot{
+	char sel;	// digit select, 0 while blanked
+	int digit;	// 0 : sec%10 ~ 3 : min/10
+	ktime_t len;	// length of slot
+};
 
-	// increase timer count
-	p_data->count++;
+// fnd refresh timer global variables
+static struct hrtimer refresh_timer;
+static unsigned long refresh_period;	// ns per digit
+static struct fnd_slot refresh_table[FND_SLOTS];
+static int refresh_slots;
+static int refresh_slot;
+static int table_duty[FND_DIGITS];	// parameters table was built from
+static int table_blank;
+static unsigned int refresh_jitter[JITTER_SLOT];
+static unsigned int refresh_count;
+static unsigned int refresh_missed;
+static s64 refresh_max;		// worst lateness (us)
+
+// seq is odd while state changes
+static void state_begin(unsigned long *flags){
+	spin_lock_irqsave(&state_lock, *flags);
+	WRITE_ONCE(state->seq, state->seq + 1);
+	smp_wmb();
+}
 
-	// set timer
-	mydata.timer.expires = get_jiffies_64() + (1 * HZ);
-	mydata.timer.data = (unsigned long)&mydata;
-	mydata.timer.function = kernel_timer_blink;
+static void state_end(unsigned long flags){
+	smp_wmb();
+	WRITE_ONCE(state->seq, state->seq + 1);
+	spin_unlock_irqrestore(&state_lock, flags);
+}
 
-	add_timer(&mydata.timer);
+// seconds counted at now, same rule as readers of page
+static int state_seconds(ktime_t now){
+	unsigned int seq;
+	s64 elapsed;
+
+	do{
+		while((seq = READ_ONCE(state->seq)) & 1)
+			cpu_relax();
+		smp_rmb();
+		elapsed = READ_ONCE(state->accum_ns);
+		if(READ_ONCE(state->running))
+			elapsed += ktime_to_ns(now) - READ_ONCE(state->start_ns);
+		smp_rmb();
+	}while(READ_ONCE(state->seq) != seq);
+
+	return div_s64(elapsed, NSEC_PER_SEC);
 }
 
 // function for terminating program
@@ -84,41 +161,57 @@ static void kernel_quit_timer(unsigned long timeout){
 	printk("program terminated!\n");
 
 	// set quit flag
-	quit_flag = 0;
+	atomic_set(&quit_flag, 0);
+	wake_up_interruptible(&wq_write);
 }
 
 // start stop watch when SW1 button pressed (interrupt)
 irqreturn_t inter_handler1(int irq, void *dev_id, struct pt_regs *reg){
-	printk("stopwatch started\n");
+	unsigned long flags;
 
-	// start stopwatch increase every 1 second
-	del_timer_sync(&mydata.timer);
-	mydata.timer.expires = jiffies + (1 * HZ);
-	mydata.timer.data = (unsigned long)&mydata;
-	mydata.timer.function = kernel_timer_blink;
+	printk("stopwatch started\n");
 
-	add_timer(&mydata.timer);
+	// count from now, time before pause is kept in accum_ns
+	state_begin(&flags);
+	if(!state->running){
+		WRITE_ONCE(state->start_ns, ktime_to_ns(ktime_get()));
+		WRITE_ONCE(state->running, 1);
+	}
+	state_end(flags);
 
 	return IRQ_HANDLED;
 }
 
 // pause stop watch when SW2 button pressed (interrupt)
 irqreturn_t inter_handler2(int irq, void *dev_id, struct pt_regs *reg){
+	unsigned long flags;
+
 	printk("stopwatch paused\n");
 
-	// remove timer handler
-	del_timer_sync(&mydata.timer);
+	// keep time counted so far, every pause is a lap
+	state_begin(&flags);
+	if(state->running){
+		WRITE_ONCE(state->accum_ns, state->accum_ns + ktime_to_ns(ktime_get()) - state->start_ns);
+		WRITE_ONCE(state->running, 0);
+		WRITE_ONCE(state->laps, state->laps + 1);
+	}
+	state_end(flags);
 
 	return IRQ_HANDLED;
 }
 
 // reset stop watch when SW3 button pressed (interrupt)
 irqreturn_t inter_handler3(int irq, void *dev_id, struct pt_regs *reg){
+	unsigned long flags;
+
 	printk("stopwatch reseted\n");
 
-	// remove timer handler
-	del_timer_sync(&mydata.timer);
-	mydata.count = 0;
+	// stop and clear counted time
+	state_begin(&flags);
+	WRITE_ONCE(state->running, 0);
+	WRITE_ONCE(state->accum_ns, 0);
+	WRITE_ONCE(state->laps, 0);
+	state_end(flags);
 
 	return IRQ_HANDLED;
 }
@@ -131,25 +224,32 @@ irqreturn_t inter_handler4(int irq, void *dev_id, struct pt_regs *reg){
 	if(gpio_get_value(S5PV310_GPX2(4)))
 		del_timer_sync(&quit_timer.timer);
 	else{
-		// add timer for terminating program
-		quit_timer.timer.expires = jiffies + (3 * HZ);
+		// add timer for terminating program, restarted if still pending
 		quit_timer.timer.function = kernel_quit_timer;
-		add_timer(&quit_timer.timer);
+		mod_timer(&quit_timer.timer, jiffies + (3 * HZ));
 	}
 
 	return IRQ_HANDLED;
 }
 
 int stopwatch_open(struct inode *minode, struct file *mfile){
+	unsigned long flags;
 	int ret;
 
-	if(stopwatch_usage != 0)
+	// readers of state page do not own the stopwatch
+	if((mfile->f_flags & O_ACCMODE) == O_RDONLY)
+		return 0;
+
+	if(atomic_cmpxchg(&stopwatch_usage, 0, 1) != 0)
 		return -EBUSY;
 
 	// set to default value
-	stopwatch_usage = 1;
-	quit_flag = 1;
-	mydata.count = 0;
+	atomic_set(&quit_flag, 1);
+	state_begin(&flags);
+	WRITE_ONCE(state->running, 0);
+	WRITE_ONCE(state->accum_ns, 0);
+	WRITE_ONCE(state->laps, 0);
+	state_end(flags);
 
 	/*
 	   *	SW2 : GPX2(0)
@@ -163,21 +263,38 @@ int stopwatch_open(struct inode *minode, struct file *mfile){
 
 	// set interrupt requests
 	ret = request_irq(gpio_to_irq(S5PV310_GPX2(0)), &inter_handler1, IRQF_TRIGGER_FALLING, "X2.0", NULL);	// SW2
+	if(ret < 0)
+		goto release;
 	ret = request_irq(gpio_to_irq(S5PV310_GPX2(1)), &inter_handler2, IRQF_TRIGGER_FALLING, "X2.1", NULL);	// SW3
+	if(ret < 0)
+		goto free_sw2;
 	ret = request_irq(gpio_to_irq(S5PV310_GPX2(2)), &inter_handler3, IRQF_TRIGGER_FALLING, "X2.2", NULL);	// SW4
+	if(ret < 0)
+		goto free_sw3;
 	ret = request_irq(gpio_to_irq(S5PV310_GPX2(4)), &inter_handler4, IRQF_TRIGGER_RISING|IRQF_TRIGGER_FALLING, "X2.3", NULL);	// SW6
+	if(ret < 0)
+		goto free_sw4;
 
 	printk("stopwatch module open\n");
 
 	return 0;
+
+	// undo in reverse order of request
+free_sw4:
+	free_irq(gpio_to_irq(S5PV310_GPX2(2)), NULL);
+free_sw3:
+	free_irq(gpio_to_irq(S5PV310_GPX2(1)), NULL);
+free_sw2:
+	free_irq(gpio_to_irq(S5PV310_GPX2(0)), NULL);
+release:
+	printk(KERN_WARNING"stopwatch irq request failed!\n");
+	atomic_set(&stopwatch_usage, 0);
+	return ret;
 }
 
 int stopwatch_release(struct inode *minode, struct file *mfile){
-	stopwatch_usage = 0;
-
-	// remove timers
-	del_timer_sync(&mydata.timer);
-	del_timer_sync(&quit_timer.timer);
+	if((mfile->f_flags & O_ACCMODE) == O_RDONLY)
+		return 0;
 
 	// fnd device off
 	outb(0x00, (unsigned int)fnd_data2);
@@ -188,11 +305,29 @@ int stopwatch_release(struct inode *minode, struct file *mfile){
 	free_irq(gpio_to_irq(S5PV310_GPX2(2)), NULL);
 	free_irq(gpio_to_irq(S5PV310_GPX2(4)), NULL);
 
+	// remove timer, SW6 handler can no longer add it again
+	del_timer_sync(&quit_timer.timer);
+
 	printk("stopwatch module release\n");
 
+	// device is free only after interrupts are released
+	atomic_set(&stopwatch_usage, 0);
+
 	return 0;
 }
 
+// map state page read only, readers compute elapsed time themselves
+int stopwatch_mmap(struct file *mfile, struct vm_area_struct *vma){
+	if(vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start > PAGE_SIZE)
+		return -EINVAL;
+	if(vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_pfn_range(vma, vma->vm_start, virt_to_phys(state) >> PAGE_SHIFT,
+			vma->vm_end - vma->vm_start, vma->vm_page_prot);
+}
+
 char convertChar(int num){
 	char chr = 0;
 
@@ -231,48 +366,131 @@ char convertChar(int num){
 	return chr;
 }
 
-ssize_t stopwatch_write(struct file *inode, const short *gdata, size_t length, loff_t *off_what){
-	char sel, dat;
-	int min, sec;
+// precompute scan slots, each digit is lit for its duty then blanked
+static void fnd_table(void){
+	static const char sel[FND_DIGITS] = {0x80, 0x10, 0x04, 0x02};
+	unsigned long lit, blank;
+	int i, n = 0;
+
+	for(i=0;i<FND_DIGITS;i++){
+		if(duty[i] < 0)
+			duty[i] = 0;
+		if(duty[i] > 100)
+			duty[i] = 100;
+		table_duty[i] = duty[i];
+	}
+	if(blank_us < 0)
+		blank_us = 0;
+	table_blank = blank_us;
+
+	blank = (unsigned long)blank_us * 1000;
+	if(blank > refresh_period)
+		blank = refresh_period;
+
+	for(i=0;i<FND_DIGITS;i++){
+		lit = (refresh_period - blank) / 100 * duty[i];
+		if(lit > 0){
+			refresh_table[n].sel = sel[i];
+			refresh_table[n].digit = i;
+			refresh_table[n++].len = ktime_set(0, lit);
+		}
+		if(refresh_period - lit > 0){
+			refresh_table[n].sel = 0;
+			refresh_table[n].digit = i;
+			refresh_table[n++].len = ktime_set(0, refresh_period - lit);
+		}
+	}
+	refresh_slots = n;
+}
 
-	printk("stopwatch write entered\n");
+// run one slot of fnd scan (hrtimer interrupt context)
+static enum hrtimer_restart fnd_refresh(struct hrtimer *timer){
+	ktime_t now = hrtimer_cb_get_time(timer);
+	struct fnd_slot *p;
+	s64 late;
+	unsigned long overrun;
+	int count, min, sec, num = 0, slot = 0;
+
+	// lateness of this expiry
+	late = ktime_to_us(ktime_sub(now, hrtimer_get_expires(timer)));
+	if(late > refresh_max)
+		refresh_max = late;
+	while(late > 1 && slot < JITTER_SLOT - 1){
+		late >>= 1;
+		slot++;
+	}
+	refresh_jitter[slot]++;
+	refresh_count++;
+
+	// parameters changed, rebuild table at end of scan
+	if(refresh_slot == 0 && (blank_us != table_blank
+				|| memcmp(duty, table_duty, sizeof(duty)) != 0))
+		fnd_table();
+	p = &refresh_table[refresh_slot];
+	refresh_slot = (refresh_slot + 1) % refresh_slots;
+
+	// count minutes and seconds, min wraps to 0 after 59
+	count = state_seconds(now) % 3600;
+	min = count / 60;
+	sec = count % 60;
+
+	switch(p->digit){
+		case 0:
+			num = sec%10;
+			break;
+		case 1:
+			num = sec/10;
+			break;
+		case 2:
+			num = min%10;
+			break;
+		case 3:
+			num = min/10;
+			break;
+	}
 
-	while(quit_flag){
-		// count minutes and seconds
-		min = mydata.count / 60;
-		sec = mydata.count % 60;
+	// blank before changing segments, no ghost of previous digit
+	outb(0x00, (unsigned int)fnd_data2);
+	if(p->sel != 0){
+		outb(convertChar(num), (unsigned int)fnd_data);
+		outb(p->sel, (unsigned int)fnd_data2);
+	}
 
-		// if min reaches max value set to 0
-		if(min == 60){
-			mydata.count = 0;
-			min = 0;
-		}
+	// periods passed without refresh are missed deadlines
+	overrun = hrtimer_forward(timer, now, p->len);
+	if(overrun > 1)
+		refresh_missed += overrun - 1;
 
-		// print values on fnd device
-		sel = 0x80;
-		outb(sel, (unsigned int)fnd_data2);
-		dat = convertChar(sec%10);
-		outb(dat, (unsigned int)fnd_data);
-		msleep(5);
-
-		sel = 0x10;
-		outb(sel, (unsigned int)fnd_data2);
-		dat = convertChar(sec/10);
-		outb(dat, (unsigned int)fnd_data);
-		msleep(5);
-
-		sel = 0x04;
-		outb(sel, (unsigned int)fnd_data2);
-		dat = convertChar(min%10);
-		outb(dat, (unsigned int)fnd_data);
-		msleep(5);
-
-		sel = 0x02;
-		outb(sel, (unsigned int)fnd_data2);
-		dat = convertChar(min/10);
-		outb(dat, (unsigned int)fnd_data);
-		msleep(5);
-	}
+	return HRTIMER_RESTART;
+}
+
+ssize_t stopwatch_write(struct file *inode, const short *gdata, size_t length, loff_t *off_what){
+	int i;
+
+	printk("stopwatch write entered\n");
+
+	if(refresh_hz < 1)
+		refresh_hz = 1;
+
+	// start refreshing fnd, one slot per expiry
+	memset(refresh_jitter, 0, sizeof(refresh_jitter));
+	refresh_count = 0;
+	refresh_missed = 0;
+	refresh_max = 0;
+	refresh_slot = 0;
+	refresh_period = NSEC_PER_SEC / (refresh_hz * FND_DIGITS);
+	fnd_table();
+	hrtimer_start(&refresh_timer, refresh_table[0].len, HRTIMER_MODE_REL);
+
+	// sleep until program terminated
+	wait_event_interruptible(wq_write, !atomic_read(&quit_flag));
+	hrtimer_cancel(&refresh_timer);
+
+	printk("fnd refresh %dHz, %u slots, max %lldus late, %u missed\n",
+			refresh_hz, refresh_count, refresh_max, refresh_missed);
+	for(i=0;i<JITTER_SLOT;i++)
+		if(refresh_jitter[i] != 0)
+			printk("fnd refresh jitter <%dus : %u\n", 1 << i, refresh_jitter[i]);
 
 	return 0;
 }
@@ -320,9 +538,18 @@ int __init stopwatch_init(void){
 	outb(0xFF, (unsigned int)fnd_data);
 	// FND driver initialization ended
 
+	// page of stopwatch state, mapped by readers
+	state = (struct stopwatch_page *)get_zeroed_page(GFP_KERNEL);
+	if(state == NULL){
+		unregister_chrdev(DEV_MAJOR, DEV_NAME);
+		return -ENOMEM;
+	}
+	SetPageReserved(virt_to_page(state));
+
 	// initialize timers
-	init_timer(&(mydata.timer));
 	init_timer(&(quit_timer.timer));
+	hrtimer_init(&refresh_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	refresh_timer.function = fnd_refresh;
 
 	printk("init module, /dev/stopwatch major : %d\n", DEV_MAJOR);
 
@@ -332,6 +559,10 @@ int __init stopwatch_init(void){
 void __exit stopwatch_exit(void){
 	// unregister device driver
 	unregister_chrdev(DEV_MAJOR, DEV_NAME);
+
+	ClearPageReserved(virt_to_page(state));
+	free_page((unsigned long)state);
+
 	printk("Stopwatch module removed.\n");
 }
 
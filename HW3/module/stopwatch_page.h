@@ -0,0 +1,45 @@
+/* State of stopwatch, one read only page mapped from /dev/stopwatch
+   (open O_RDONLY, any number of readers next to the owner of the device)
+   writer makes seq odd while updating, reader retries while seq is odd or
+   changed, so elapsed time is computed at any rate without system call */
+
+#ifndef __STOPWATCH_PAGE__
+#define __STOPWATCH_PAGE__
+
+struct stopwatch_page{
+	volatile unsigned int seq;
+	unsigned int running;		// 1 while counting
+	long long start_ns;		// CLOCK_MONOTONIC of last start
+	long long accum_ns;		// counted before last start
+	unsigned int laps;		// pauses since reset
+	unsigned int pad;
+};
+
+#ifndef __KERNEL__
+#ifndef READ_ONCE
+#define READ_ONCE(x) (*(volatile __typeof__(x) *)&(x))
+#endif
+
+// elapsed ns at now_ns (CLOCK_MONOTONIC), laps may be NULL
+static inline long long stopwatch_elapsed(const struct stopwatch_page *p, long long now_ns, unsigned int *laps){
+	unsigned int seq, lap;
+	long long elapsed;
+
+	do{
+		while((seq = READ_ONCE(p->seq)) & 1)
+			;
+		__sync_synchronize();
+		elapsed = READ_ONCE(p->accum_ns);
+		if(READ_ONCE(p->running))
+			elapsed += now_ns - READ_ONCE(p->start_ns);
+		lap = READ_ONCE(p->laps);
+		__sync_synchronize();
+	}while(READ_ONCE(p->seq) != seq);
+
+	if(laps != NULL)
+		*laps = lap;
+	return elapsed;
+}
+#endif
+
+#endif
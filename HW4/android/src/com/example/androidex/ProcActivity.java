@@ -1,8 +1,7 @@
 package com.example.androidex;
 
-import java.io.BufferedReader;
-import java.io.FileReader;
 import java.io.IOException;
+import java.io.RandomAccessFile;
 import android.annotation.SuppressLint;
 import android.app.Activity;
 import android.os.Bundle;
@@ -39,7 +38,11 @@ public class ProcActivity extends Activity{
 		read_listener = new OnClickListener(){
 			@Override
 			public void onClick(View v){
-				CPUThread.CPUUsages();
+				new Thread(){
+					public void run(){
+						CPUThread.CPUUsages();
+					}
+				}.start();
 			}
 		};
 		btn_read.setOnClickListener(read_listener);
@@ -82,34 +85,10 @@ public class ProcActivity extends Activity{
 	Handler mHandler = new Handler(){
 		public void handleMessage(Message msg){
 			if(msg.what == 0){
-				try{
-					FileReader fis = new FileReader("/proc/stat");
-					BufferedReader br = new BufferedReader(fis);
-					
-					String str = null;
-					String[] columns = null;
-					
-					// Read /proc/stat/ then split strings into tokens
-					str = br.readLine();
-					columns = str.split(" ");
-					
-					// Calculate CPU usage
-					int total_jiffies = 0;
-					int usage;
-					total_jiffies += Integer.parseInt(columns[2]);
-					total_jiffies += Integer.parseInt(columns[3]);
-					total_jiffies += Integer.parseInt(columns[4]);
-					total_jiffies += Integer.parseInt(columns[5]);
-					usage = Integer.parseInt(columns[5])*100 / total_jiffies;
-					usage = 100 - usage;	// 100 - idle time
-					
-					// Change text label
-					text_info.setText("/proc/stat : " + str);
-					text_usage.setText("cpu usage : " + String.valueOf(usage) + "%");
-					
-					fis.close();
-					br.close();
-				} catch(IOException e){}
+				// Change text label (parsed by CPUThread)
+				text_info.setText("/proc/stat : " + (String)msg.obj);
+				if(msg.arg1 >= 0)
+					text_usage.setText("cpu usage : " + String.valueOf(msg.arg1) + "%");
 			}
 		}
 	};
@@ -117,6 +96,8 @@ public class ProcActivity extends Activity{
 
 class CPUThread extends Thread{
 	static Handler mHandler;
+	static RandomAccessFile stat;
+	static long prev_busy = -1, prev_total = -1;
 	
 	// Constructor for handler
 	CPUThread(Handler handler){
@@ -132,10 +113,47 @@ class CPUThread extends Thread{
 		} catch(InterruptedException e){;}
 	}
 	
-	// Make message for CPU usage running
-	public static void CPUUsages(){
+	// Parse first line of /proc/stat and send usage since last sample
+	public static synchronized void CPUUsages(){
+		String str;
+		long busy = 0, total = 0, value;
+		int usage = -1, column = 0, i;
+		
+		try{
+			// Keep /proc/stat open, read again from the start
+			if(stat == null)
+				stat = new RandomAccessFile("/proc/stat", "r");
+			stat.seek(0);
+			str = stat.readLine();
+		} catch(IOException e){
+			return;
+		}
+		
+		// cpu user nice system idle iowait irq softirq ...
+		for(i=3;i<str.length();i++){
+			if(str.charAt(i) < '0' || str.charAt(i) > '9')
+				continue;
+			
+			value = 0;
+			while(i < str.length() && str.charAt(i) >= '0' && str.charAt(i) <= '9')
+				value = value*10 + (str.charAt(i++) - '0');
+			
+			total += value;
+			if(column != 3 && column != 4)	// idle and iowait
+				busy += value;
+			column++;
+		}
+		
+		// Calculate CPU usage of the interval
+		if(prev_total >= 0 && total != prev_total)
+			usage = (int)((busy - prev_busy)*100 / (total - prev_total));
+		prev_busy = busy;
+		prev_total = total;
+		
 		Message msg = Message.obtain();
 		msg.what = 0;
+		msg.arg1 = usage;
+		msg.obj = str;
 		mHandler.sendMessage(msg);
 	}
-}
\ No newline at end of file
+}
@@ -3,7 +3,7 @@ LOCAL_PATH:=$(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_MODULE:=dangercloz_module
-LOCAL_SRC_FILES:=TextEditor.c FigureSwitch.c Watch.c PuzzleCount.c Mode.c
+LOCAL_SRC_FILES:=TextEditor.c FigureSwitch.c Watch.c PuzzleCount.c Mode.c CpuUsage.c Trace.c Device.c T9.c
 LOCAL_LDLIBS := -llog
 #LOCAL_LDLIB := -L$(SYSROOT)/usr/lib -llog
 
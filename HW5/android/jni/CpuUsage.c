@@ -0,0 +1,402 @@
+#include <jni.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/syscall.h>
+
+#define MAX_CPU 8		// cpu lines to keep (cpu0 ~ cpu7)
+#define MAX_THREAD 8		// threads to profile
+#define HISTORY 64		// samples kept in history ring
+#define STAT_SIZE 4096		// /proc/stat read buffer
+#define MIN_INTERVAL 10		// minimum sampling interval (ms)
+
+// Cumulative jiffies of one cpu line
+struct cpu_times{
+	unsigned long long busy;
+	unsigned long long total;
+};
+
+// Thread registered for profiling
+struct cpu_thread{
+	int tid;		// 0 if slot is empty
+	char name[16];
+	int stat_fd;		// /proc/self/task/<tid>/stat
+	int status_fd;		// /proc/self/task/<tid>/status
+	unsigned long long ticks;	// utime + stime
+	unsigned long long ctxt;	// voluntary + involuntary switches
+};
+
+// One sample of history (usage in percent, index 0 is total cpu)
+struct cpu_record{
+	long long time;		// monotonic time (ms)
+	int count;		// number of valid usages (total + cpu N)
+	int usage[MAX_CPU + 1];
+	int ctxt;		// system context switches per second
+	int thread_usage[MAX_THREAD];	// percent of one cpu, -1 if empty
+	int thread_ctxt[MAX_THREAD];	// context switches per second
+};
+
+static struct cpu_sampler{
+	pthread_t thread;
+	int running;		// 1 while sampler thread is alive
+	int interval;		// sampling interval (ms)
+	int fd;			// /proc/stat kept open
+	struct cpu_times prev[MAX_CPU + 1];
+	unsigned long long prev_ctxt;
+	long long prev_time;
+	struct cpu_thread threads[MAX_THREAD];
+	pthread_mutex_t lock;	// protects thread table (not samples)
+	volatile unsigned int seq;	// odd while history is being written
+	unsigned int head;	// number of records written
+	struct cpu_record history[HISTORY];
+} sampler = { .fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER };
+
+// Parse unsigned decimal number and move pointer after it
+static unsigned long long parse_num(const char **p){
+	unsigned long long num = 0;
+	const char *s = *p;
+
+	while(*s == ' ')
+		s++;
+	while(*s >= '0' && *s <= '9')
+		num = num*10 + (*s++ - '0');
+
+	*p = s;
+	return num;
+}
+
+// Move pointer to the start of next line
+static const char *next_line(const char *s){
+	while(*s != '\n' && *s != '\0')
+		s++;
+	if(*s == '\n')
+		s++;
+
+	return s;
+}
+
+// Parse "cpu" and "ctxt" lines of /proc/stat, returns number of cpu lines
+static int parse_stat(const char *s, struct cpu_times *times, unsigned long long *ctxt){
+	unsigned long long value;
+	int i, n = 0;
+
+	while(*s != '\0'){
+		if(n <= MAX_CPU && s[0] == 'c' && s[1] == 'p' && s[2] == 'u'){
+			s += 3;
+			while(*s != ' ' && *s != '\0')	// skip cpu number
+				s++;
+
+			// user nice system idle iowait irq softirq (steal ...)
+			times[n].busy = 0;
+			times[n].total = 0;
+			for(i=0;*s == ' ';i++){
+				value = parse_num(&s);
+				times[n].total += value;
+				if(i != 3 && i != 4)	// idle and iowait are not busy
+					times[n].busy += value;
+			}
+			n++;
+		} else if(strncmp(s, "ctxt ", 5) == 0){
+			s += 4;
+			*ctxt = parse_num(&s);
+		}
+
+		s = next_line(s);
+	}
+
+	return n;
+}
+
+// Read utime + stime and context switches of a thread, -1 if it is gone
+static int parse_thread(struct cpu_thread *t){
+	char buff[1024];
+	const char *s;
+	int i, len;
+
+	// fields after "(comm)" : state ppid ... utime(14) stime(15)
+	if((len = pread(t->stat_fd, buff, sizeof(buff) - 1, 0)) <= 0)
+		return -1;
+	buff[len] = '\0';
+	if((s = strrchr(buff, ')')) == NULL)
+		return -1;
+	for(s+=2, i=3;i<14;i++)
+		while(*s != '\0' && *s++ != ' ');
+	t->ticks = parse_num(&s);
+	t->ticks += parse_num(&s);
+
+	if((len = pread(t->status_fd, buff, sizeof(buff) - 1, 0)) <= 0)
+		return -1;
+	buff[len] = '\0';
+	t->ctxt = 0;
+	for(s=buff;*s!='\0';s=next_line(s)){
+		if(strncmp(s, "voluntary_ctxt_switches:", 24) == 0){
+			s += 24;
+			t->ctxt += parse_num(&s);
+		} else if(strncmp(s, "nonvoluntary_ctxt_switches:", 27) == 0){
+			s += 27;
+			t->ctxt += parse_num(&s);
+		}
+	}
+
+	return 0;
+}
+
+static void thread_close(struct cpu_thread *t){
+	close(t->stat_fd);
+	close(t->status_fd);
+	t->tid = 0;
+}
+
+// Take one sample and append usage of the interval since last sample
+static void cpu_sample(int first){
+	struct cpu_times now[MAX_CPU + 1];
+	struct cpu_record *rec;
+	struct cpu_thread *t, old;
+	struct timespec ts;
+	char buff[STAT_SIZE];
+	unsigned long long busy, total, ctxt = 0;
+	long long time, elapsed;
+	int i, n, len;
+
+	if((len = pread(sampler.fd, buff, sizeof(buff) - 1, 0)) <= 0)
+		return;
+	buff[len] = '\0';
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	time = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+	elapsed = time - sampler.prev_time;
+	if(elapsed <= 0)
+		elapsed = 1;
+
+	n = parse_stat(buff, now, &ctxt);
+	total = now[0].total - sampler.prev[0].total;
+
+	rec = &sampler.history[sampler.head % HISTORY];
+	sampler.seq++;
+	__sync_synchronize();
+
+	rec->time = time;
+	for(i=0;i<n;i++){
+		busy = now[i].busy - sampler.prev[i].busy;
+		rec->usage[i] = now[i].total != sampler.prev[i].total ?
+			(int)(busy * 100 / (now[i].total - sampler.prev[i].total)) : 0;
+	}
+	rec->count = n;
+	rec->ctxt = (int)((ctxt - sampler.prev_ctxt) * 1000 / elapsed);
+
+	// per thread usage relative to one cpu
+	pthread_mutex_lock(&sampler.lock);
+	for(i=0;i<MAX_THREAD;i++){
+		t = &sampler.threads[i];
+		rec->thread_usage[i] = -1;
+		rec->thread_ctxt[i] = 0;
+		if(t->tid == 0)
+			continue;
+
+		old = *t;
+		if(parse_thread(t) < 0){	// thread terminated
+			thread_close(t);
+			continue;
+		}
+		if(old.ticks == (unsigned long long)-1)	// first sample of thread
+			continue;
+
+		rec->thread_usage[i] = total ? (int)((t->ticks - old.ticks) * 100 * (n > 1 ? n - 1 : 1) / total) : 0;
+		rec->thread_ctxt[i] = (int)((t->ctxt - old.ctxt) * 1000 / elapsed);
+	}
+	pthread_mutex_unlock(&sampler.lock);
+
+	__sync_synchronize();
+	sampler.seq++;
+
+	// first sample has no interval to publish
+	if(!first)
+		sampler.head++;
+
+	memcpy(sampler.prev, now, sizeof(now));
+	sampler.prev_ctxt = ctxt;
+	sampler.prev_time = time;
+}
+
+// Sampler thread, wakes up on absolute deadlines
+static void *cpu_sampler(void *arg){
+	struct timespec next;
+	long long interval;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	cpu_sample(1);
+
+	while(sampler.running){
+		interval = (long long)sampler.interval * 1000000LL;
+		next.tv_sec += interval / 1000000000LL;
+		next.tv_nsec += interval % 1000000000LL;
+		if(next.tv_nsec >= 1000000000L){
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000L;
+		}
+
+		if(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+			continue;
+
+		cpu_sample(0);
+	}
+
+	return NULL;
+}
+
+// Copy last count records (oldest first), returns number copied
+static int cpu_history(struct cpu_record *out, int count){
+	unsigned int seq, head;
+	int i;
+
+	// Retry if sampler published while copying
+	do{
+		seq = sampler.seq;
+		__sync_synchronize();
+		head = sampler.head;
+		if(count > (int)head)
+			count = head;
+		if(count > HISTORY - 1)	// slot at head may be under writing
+			count = HISTORY - 1;
+		for(i=0;i<count;i++)
+			out[i] = sampler.history[(head - count + i) % HISTORY];
+		__sync_synchronize();
+	} while((seq & 1) || seq != sampler.seq);
+
+	return count;
+}
+
+void Java_com_example_androidex_CpuSampler_start (JNIEnv *env, jclass clazz, jint interval){
+	if(interval < MIN_INTERVAL)
+		interval = MIN_INTERVAL;
+	sampler.interval = interval;
+
+	// Only change interval if already running
+	if(!__sync_bool_compare_and_swap(&sampler.running, 0, 1))
+		return;
+
+	if(sampler.fd < 0 && (sampler.fd = open("/proc/stat", O_RDONLY)) < 0){
+		perror("/proc/stat open error");
+		sampler.running = 0;
+		return;
+	}
+
+	if(pthread_create(&sampler.thread, NULL, cpu_sampler, NULL) != 0)
+		sampler.running = 0;
+}
+
+void Java_com_example_androidex_CpuSampler_stop (JNIEnv *env, jclass clazz){
+	if(!__sync_bool_compare_and_swap(&sampler.running, 1, 0))
+		return;
+
+	pthread_join(sampler.thread, NULL);
+}
+
+jintArray Java_com_example_androidex_CpuSampler_usage (JNIEnv *env, jclass clazz){
+	struct cpu_record rec;
+	jintArray result;
+
+	if(cpu_history(&rec, 1) == 0)
+		rec.count = 0;
+
+	result = (*env)->NewIntArray(env, rec.count);
+	(*env)->SetIntArrayRegion(env, result, 0, rec.count, rec.usage);
+
+	return result;
+}
+
+// Register calling thread for profiling, returns slot or -1
+jint Java_com_example_androidex_CpuSampler_watch (JNIEnv *env, jclass clazz, jstring name){
+	struct cpu_thread *t;
+	char path[64];
+	int i, tid = syscall(__NR_gettid);
+
+	pthread_mutex_lock(&sampler.lock);
+	for(i=0;i<MAX_THREAD;i++)
+		if(sampler.threads[i].tid == 0 || sampler.threads[i].tid == tid)
+			break;
+
+	if(i < MAX_THREAD){
+		t = &sampler.threads[i];
+		if(t->tid == tid)
+			thread_close(t);
+
+		sprintf(path, "/proc/self/task/%d/stat", tid);
+		t->stat_fd = open(path, O_RDONLY);
+		sprintf(path, "/proc/self/task/%d/status", tid);
+		t->status_fd = open(path, O_RDONLY);
+
+		if(t->stat_fd < 0 || t->status_fd < 0){
+			close(t->stat_fd);
+			close(t->status_fd);
+			i = -1;
+		} else{
+			const char *str = (*env)->GetStringUTFChars(env, name, 0);
+			strncpy(t->name, str, sizeof(t->name) - 1);
+			t->name[sizeof(t->name) - 1] = '\0';
+			(*env)->ReleaseStringUTFChars(env, name, str);
+
+			t->ticks = (unsigned long long)-1;
+			t->tid = tid;
+		}
+	} else
+		i = -1;
+	pthread_mutex_unlock(&sampler.lock);
+
+	return i;
+}
+
+// Profile report of history : per cpu and per thread (last / average / max)
+jstring Java_com_example_androidex_CpuSampler_profile (JNIEnv *env, jclass clazz){
+	struct cpu_record recs[HISTORY];
+	char report[2048], name[16];
+	int i, j, n, len, sum, max, valid;
+
+	n = cpu_history(recs, HISTORY);
+	if(n == 0)
+		return (*env)->NewStringUTF(env, "no sample yet");
+
+	len = sprintf(report, "%d samples, ctxt %d/s\n", n, recs[n-1].ctxt);
+
+	for(j=0;j<recs[n-1].count;j++){
+		for(i=0, sum=0, max=0;i<n;i++){
+			sum += recs[i].usage[j];
+			if(recs[i].usage[j] > max)
+				max = recs[i].usage[j];
+		}
+
+		if(j == 0)
+			len += sprintf(report + len, "cpu  ");
+		else
+			len += sprintf(report + len, "cpu%d ", j - 1);
+		len += sprintf(report + len, "%3d%% avg %3d%% max %3d%%\n", recs[n-1].usage[j], sum / n, max);
+	}
+
+	for(j=0;j<MAX_THREAD;j++){
+		pthread_mutex_lock(&sampler.lock);
+		strcpy(name, sampler.threads[j].name);
+		pthread_mutex_unlock(&sampler.lock);
+
+		if(recs[n-1].thread_usage[j] < 0)
+			continue;
+
+		for(i=0, sum=0, max=0, valid=0;i<n;i++){
+			if(recs[i].thread_usage[j] < 0)
+				continue;
+			valid++;
+			sum += recs[i].thread_usage[j];
+			if(recs[i].thread_usage[j] > max)
+				max = recs[i].thread_usage[j];
+		}
+
+		len += sprintf(report + len, "%-10s %3d%% avg %3d%% max %3d%% ctxt %d/s\n", name,
+				recs[n-1].thread_usage[j], sum / valid, max, recs[n-1].thread_ctxt[j]);
+	}
+
+	return (*env)->NewStringUTF(env, report);
+}
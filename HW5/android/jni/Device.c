@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/mman.h>
+#include "Device.h"
+#include "Trace.h"
+#include "fpga_fb.h"
+#include "fpga_switch.h"
+
+#define SWITCH_POLL 10		// push switch polling interval (ms)
+#define SWITCH_EVENTS 16	// switch events read at once
+
+// Command queued by any thread
+struct dev_cmd{
+	struct dev_cmd *volatile next;
+	int dev;
+	int len;
+	unsigned char data[DEV_DATA_MAX];
+};
+
+// Value of a device (pending or last written)
+struct dev_value{
+	int valid;
+	int len;
+	unsigned char data[DEV_DATA_MAX];
+};
+
+static const char *dev_path[DEV_COUNT] = {
+	"/dev/fnd_driver", "/dev/led_driver", "/dev/fpga_led", "/dev/fpga_dot",
+	"/dev/fpga_fnd", "/dev/fpga_text_lcd", "/dev/fpga_push_switch"
+};
+
+static struct dev_owner{
+	pthread_t thread;
+	int fd[DEV_COUNT];
+	int event_fd;		// wakes up device thread on new command
+	int timer_fd;		// push switch polling
+	int switch_fd;		// push switch events, -1 if polled
+	struct dev_value pending[DEV_COUNT];
+	struct dev_value shadow[DEV_COUNT];	// last written value
+	struct dev_cmd *volatile head;	// producers push here
+	struct dev_cmd *tail;		// only device thread pops
+	struct dev_cmd stub;
+	volatile unsigned int push_sw;	// switch state (bit per switch)
+	volatile unsigned int push_latch;	// pressed since last dev_switch
+	struct fpga_fb *fb;		// /dev/fpga_fb page, NULL if not loaded
+} owner;
+
+static pthread_once_t dev_once = PTHREAD_ONCE_INIT;
+
+// Multiple producer single consumer queue (intrusive, lock-free)
+static void dev_push(struct dev_cmd *cmd){
+	struct dev_cmd *prev;
+
+	cmd->next = NULL;
+	__sync_synchronize();
+	prev = __sync_lock_test_and_set(&owner.head, cmd);
+	prev->next = cmd;
+}
+
+static struct dev_cmd *dev_pop(void){
+	struct dev_cmd *tail = owner.tail;
+	struct dev_cmd *next = tail->next;
+
+	if(tail == &owner.stub){
+		if(next == NULL)
+			return NULL;
+		owner.tail = next;
+		tail = next;
+		next = next->next;
+	}
+
+	if(next != NULL){
+		owner.tail = next;
+		return tail;
+	}
+
+	// producer is between exchange and link, try again later
+	if(tail != owner.head)
+		return NULL;
+
+	dev_push(&owner.stub);
+	next = tail->next;
+	if(next != NULL){
+		owner.tail = next;
+		return tail;
+	}
+
+	return NULL;
+}
+
+// Region of framebuffer page for device, NULL if written by system call
+static unsigned char *dev_fb_region(int dev, int *size){
+	if(owner.fb == NULL)
+		return NULL;
+
+	switch(dev){
+		case DEV_FPGA_DOT:
+			*size = FPGA_FB_DOT;
+			return owner.fb->dot;
+		case DEV_FPGA_FND:
+			*size = FPGA_FB_FND;
+			return owner.fb->fnd;
+		case DEV_FPGA_TEXT:
+			*size = FPGA_FB_TEXT;
+			return owner.fb->text;
+		case DEV_FPGA_LED:
+			*size = 1;
+			return &owner.fb->led;
+	}
+
+	return NULL;
+}
+
+// Write pending values, skip values same as on the device
+static void dev_flush(void){
+	unsigned char *region;
+	int size;
+	struct dev_value *p, *s;
+	int i;
+
+	for(i=0;i<DEV_COUNT;i++){
+		p = &owner.pending[i];
+		s = &owner.shadow[i];
+		if(!p->valid)
+			continue;
+		p->valid = 0;
+
+		if(s->valid && s->len == p->len && memcmp(s->data, p->data, p->len) == 0)
+			continue;
+
+		// framebuffer driver flushes page to device on its own
+		if((region = dev_fb_region(i, &size)) != NULL)
+			memcpy(region, p->data, p->len < size ? p->len : size);
+		else
+			trace_write(i, owner.fd[i], p->data, p->len);
+		*s = *p;
+		s->valid = 1;
+	}
+}
+
+static void dev_poll_switch(void){
+	unsigned char push_sw[DEV_SWITCH];
+	unsigned int state = 0;
+	int i;
+
+	if(trace_read(DEV_PUSH_SWITCH, owner.fd[DEV_PUSH_SWITCH], push_sw, DEV_SWITCH) != DEV_SWITCH)
+		return;
+
+	for(i=0;i<DEV_SWITCH;i++)
+		if(push_sw[i] == 1)
+			state |= 1 << i;
+	__sync_fetch_and_or(&owner.push_latch, state & ~owner.push_sw);
+	owner.push_sw = state;
+}
+
+// Apply queued switch events, no press is lost between two dev_switch
+static void dev_read_switch(void){
+	struct fpga_switch_event ev[SWITCH_EVENTS];
+	unsigned int state = owner.push_sw;
+	int i, n;
+
+	while((n = read(owner.switch_fd, ev, sizeof(ev))) > 0){
+		for(i=0;i<n/sizeof(ev[0]);i++){
+			if(ev[i].sw >= DEV_SWITCH)
+				continue;
+			if(ev[i].value){
+				state |= 1 << ev[i].sw;
+				__sync_fetch_and_or(&owner.push_latch, 1 << ev[i].sw);
+			}
+			else
+				state &= ~(1 << ev[i].sw);
+		}
+		owner.push_sw = state;
+	}
+}
+
+// Device thread, the only one touching device files
+static void *dev_loop(void *arg){
+	struct epoll_event ev[2];
+	struct dev_cmd *cmd;
+	unsigned long long count;
+	int i, n;
+	int epoll_fd;
+
+	epoll_fd = epoll_create(2);
+	ev[0].events = EPOLLIN;
+	ev[0].data.fd = owner.event_fd;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, owner.event_fd, &ev[0]);
+	ev[0].events = EPOLLIN;
+	ev[0].data.fd = owner.switch_fd >= 0 ? owner.switch_fd : owner.timer_fd;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, ev[0].data.fd, &ev[0]);
+
+	while(1){
+		if((n = epoll_wait(epoll_fd, ev, 2, -1)) < 0){
+			if(errno == EINTR)
+				continue;
+			perror("epoll_wait error");
+			break;
+		}
+
+		for(i=0;i<n;i++){
+			if(ev[i].data.fd == owner.switch_fd){
+				dev_read_switch();
+				continue;
+			}
+
+			read(ev[i].data.fd, &count, sizeof(count));
+
+			if(ev[i].data.fd == owner.timer_fd)
+				dev_poll_switch();
+		}
+
+		// Coalesce queued commands, latest value of each device wins
+		while((cmd = dev_pop()) != NULL){
+			owner.pending[cmd->dev].valid = 1;
+			owner.pending[cmd->dev].len = cmd->len;
+			memcpy(owner.pending[cmd->dev].data, cmd->data, cmd->len);
+			free(cmd);
+		}
+
+		dev_flush();
+	}
+
+	close(epoll_fd);
+	return NULL;
+}
+
+static void dev_init(void){
+	struct itimerspec its;
+	void *map;
+	int i, fd;
+
+	// Open every device once
+	for(i=0;i<DEV_COUNT;i++)
+		if((owner.fd[i] = open(dev_path[i], i == DEV_PUSH_SWITCH ? O_RDWR : O_WRONLY)) < 0)
+			perror(dev_path[i]);
+
+	// FPGA displays through shared page when framebuffer driver is loaded
+	if((fd = open("/dev/fpga_fb", O_RDWR)) >= 0){
+		map = mmap(NULL, sizeof(struct fpga_fb), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+		if(map != MAP_FAILED)
+			owner.fb = map;
+		close(fd);
+	}
+
+	owner.head = &owner.stub;
+	owner.tail = &owner.stub;
+	owner.event_fd = eventfd(0, EFD_NONBLOCK);
+
+	// Sleep until switch event (fpga_core), else poll push switch periodically
+	owner.timer_fd = -1;
+	if((owner.switch_fd = open("/dev/fpga_push_event", O_RDONLY|O_NONBLOCK)) < 0){
+		owner.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+		its.it_interval.tv_sec = 0;
+		its.it_interval.tv_nsec = SWITCH_POLL * 1000000L;
+		its.it_value = its.it_interval;
+		timerfd_settime(owner.timer_fd, 0, &its, NULL);
+	}
+
+	pthread_create(&owner.thread, NULL, dev_loop, NULL);
+}
+
+void dev_write(enum fpga_device dev, const void *data, int len){
+	struct dev_cmd *cmd;
+	unsigned long long one = 1;
+
+	pthread_once(&dev_once, dev_init);
+
+	if(len > DEV_DATA_MAX)
+		len = DEV_DATA_MAX;
+	if((cmd = malloc(sizeof(*cmd))) == NULL)
+		return;
+	cmd->dev = dev;
+	cmd->len = len;
+	memcpy(cmd->data, data, len);
+
+	dev_push(cmd);
+	write(owner.event_fd, &one, sizeof(one));
+}
+
+void dev_switch(unsigned char *push_sw){
+	unsigned int state;
+	int i;
+
+	pthread_once(&dev_once, dev_init);
+
+	// short press shows once even if released already
+	state = owner.push_sw | __sync_fetch_and_and(&owner.push_latch, 0);
+	for(i=0;i<DEV_SWITCH;i++)
+		push_sw[i] = (state >> i) & 1;
+}
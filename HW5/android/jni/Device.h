@@ -0,0 +1,29 @@
+/* Device owner of dangercloz_module
+   one native thread opens every FPGA device once and serializes access,
+   any thread submits updates through a lock-free queue */
+
+#ifndef __DANGERCLOZ_DEVICE__
+#define __DANGERCLOZ_DEVICE__
+
+// Devices owned by device thread
+enum fpga_device{
+	DEV_FND,		// /dev/fnd_driver
+	DEV_LED,		// /dev/led_driver
+	DEV_FPGA_LED,		// /dev/fpga_led
+	DEV_FPGA_DOT,		// /dev/fpga_dot
+	DEV_FPGA_FND,		// /dev/fpga_fnd
+	DEV_FPGA_TEXT,		// /dev/fpga_text_lcd
+	DEV_PUSH_SWITCH,	// /dev/fpga_push_switch
+	DEV_COUNT
+};
+
+#define DEV_DATA_MAX 32		// largest write (text lcd)
+#define DEV_SWITCH 9		// number of push switches
+
+// Queue new value of a device (only the latest value is written)
+void dev_write(enum fpga_device dev, const void *data, int len);
+
+// Copy latest push switch state (switches pressed since last call are set)
+void dev_switch(unsigned char *push_sw);
+
+#endif
@@ -5,52 +5,42 @@
 #include <fcntl.h>
 #include <dirent.h>
 #include <errno.h>
+#include "Device.h"
+#include "Trace.h"
+#include "dot_font.h"
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
 
-unsigned char dot_number[10][10] = {
-		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00}, // 0
-		{0x7F,0x7F,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60}, // 1
-		{0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x7F,0x7F}, // 2
-		{0x7F,0x7F,0x60,0x60,0x7F,0x7F,0x60,0x60,0x60,0x60}, // 3
-		{0x03,0x03,0x03,0x03,0x7F,0x7F,0x03,0x03,0x7F,0x7F}, // 4
-		{0x7F,0x7F,0x60,0x60,0x7F,0x7F,0x60,0x60,0x7F,0x7F}, // 5
-		{0x7F,0x7F,0x03,0x03,0x7F,0x7F,0x03,0x03,0x7F,0x7F}, // 6
-		{0x7F,0x7F,0x63,0x63,0x7F,0x7F,0x60,0x60,0x7F,0x7F}, // 7
-		{0x7F,0x7F,0x03,0x03,0x7F,0x7F,0x63,0x63,0x7F,0x7F}, // 8
-		{0x3e,0x7f,0x63,0x63,0x7f,0x3f,0x03,0x03,0x03,0x03} // 9
-};
+// Native figure switch sequencer (runs without java)
+static struct figure_seq{
+	pthread_t thread;
+	int running;	// 1 while sequencer thread is alive
+	int joinable;	// thread finished but not yet joined
+	int stop_fd;	// eventfd to wake up sequencer for stop
+	int time;	// interval (x 100ms)
+	int num;	// number of steps
+	char option[5];	// current option (HW2 style)
+	char id[16];	// student id (scrolling)
+	char name[16];	// student name (scrolling)
+	int id_flag;	// direction flag of id text
+	int name_flag;	// direction flag of name text
+	JavaVM *vm;
+	jobject obj;	// global reference of activity
+	jmethodID callback;	// void onSequence(int left, int value)
+} seq = { .stop_fd = -1 };
+static pthread_mutex_t seq_lock = PTHREAD_MUTEX_INITIALIZER;
 
-void Java_com_example_androidex_FigureActivity_FigureSwitch (JNIEnv *env, jobject thiz, jstring option, jstring left){
-	int fnd_dev, fndposition, fndvalue;
-	int fpga_led, gpio_led, fpga_dot, fpga_fnd;
-	int i, dot_size, dot_num, num;
-	unsigned char fpga_led_dat, led_dat, num_dat[4];
-
-	// Open gpio fnd driver
-	if((fnd_dev = open("/dev/fnd_driver", O_WRONLY)) < 0)
-		perror("/dev/fnd_driver open error");
-
-	// Open fpga led driver
-	if((fpga_led = open("/dev/fpga_led", O_WRONLY)) < 0)
-		perror("/dev/fpga_led open error");
-
-	// Open gpio led driver
-	if((gpio_led = open("/dev/led_driver", O_WRONLY)) < 0)
-		perror("/dev/led_driver open error");
-
-	// Open fpga dot driver
-	if((fpga_dot = open("/dev/fpga_dot", O_WRONLY)) < 0)
-		perror("/dev/fpga_dot open error");
-	dot_size = sizeof(dot_number[10]);
-
-	// Open fpga fnd driver
-	if((fpga_fnd = open("/dev/fpga_fnd", O_WRONLY)) < 0)
-		perror("/dev/fpga_led open error");
+// Print option and number left on devices, returns value of the char
+static char figure_print(const char *str, int num){
+	int i, dot_size, dot_num;
+	int fndposition, fndvalue;
+	unsigned char fpga_led_dat, led_dat, num_dat[5];
 
-	// Conver jstring to c string
-	const char *str = (*env)->GetStringUTFChars(env, option, 0);
-	const char *str2 = (*env)->GetStringUTFChars(env, left, 0);
-
-	num = atoi(str2);
+	dot_size = DOT_FONT_ROWS;
 	sprintf(num_dat, "%04d", num);
 
 	// Find where the value is
@@ -83,7 +73,7 @@ void Java_com_example_androidex_FigureActivity_FigureSwitch (JNIEnv *env, jobjec
 	}
 
 	// Copy value of the char
-	switch(str[i]){
+	switch(i < 4 ? str[i] : '0'){
 		case '1':
 			fndvalue = 0x73;
 			fpga_led_dat = 128;
@@ -137,27 +127,226 @@ void Java_com_example_androidex_FigureActivity_FigureSwitch (JNIEnv *env, jobjec
 	temp = (temp<<8)|fndvalue;
 
 	// Write on devices
-	write(fnd_dev, &temp, sizeof(short));
-	write(fpga_led, &fpga_led_dat, 1);
-	write(gpio_led, &led_dat, 1);
-	write(fpga_dot, dot_number[dot_num], dot_size);
-	write(fpga_fnd, &num_dat, 4);
-
-	// Close devices
-	close(fnd_dev);
-	close(fpga_led);
-	close(gpio_led);
-	close(fpga_dot);
-	close(fpga_fnd);
+	dev_write(DEV_FND, &temp, sizeof(short));
+	dev_write(DEV_FPGA_LED, &fpga_led_dat, 1);
+	dev_write(DEV_LED, &led_dat, 1);
+	dev_write(DEV_FPGA_DOT, dot_glyph(DOT_FIGURE0 + dot_num), dot_size);
+	dev_write(DEV_FPGA_FND, &num_dat, 4);
+
+	return dot_num ? str[i] : 0;
+}
+
+void Java_com_example_androidex_FigureActivity_FigureSwitch (JNIEnv *env, jobject thiz, jstring option, jstring left){
+	trace_call(TRACE_FIGURE_SWITCH);
+
+	// Conver jstring to c string
+	const char *str = (*env)->GetStringUTFChars(env, option, 0);
+	const char *str2 = (*env)->GetStringUTFChars(env, left, 0);
+
+	figure_print(str, atoi(str2));
+
+	(*env)->ReleaseStringUTFChars(env, option, str);
+	(*env)->ReleaseStringUTFChars(env, left, str2);
 }       
 
+// Move option to next value (same rule as assignment #2)
+static void figure_next(char *op){
+	int j;
+
+	// Find where the char is
+	for(j=0;j<4;j++)
+		if(op[j] != '0')
+			break;
+	if(j == 4)
+		return;
+
+	if(op[j] != '8'){
+		op[j]++;
+	} else{
+		if(j != 3){
+			op[j+1] = '1';
+			op[j] = '0';
+		} else{
+			op[j] = '0';
+			op[0] = '1';
+		}
+	}
+}
+
+// Move text to left or right, change direction at the end
+static void figure_scroll(char *text, int *flag){
+	int k;
+
+	if(*flag == 1){	// Move string to right
+		for(k=15;k>0;k--)
+			text[k] = text[k-1];
+		text[0] = ' ';
+
+		if(text[15] != ' ')	// Change direction
+			*flag = 0;
+	} else{	// Move string to left
+		for(k=0;k<15;k++)
+			text[k] = text[k+1];
+		text[15] = ' ';
+
+		if(text[0] != ' ')	// Change direction
+			*flag = 1;
+	}
+}
+
+static void figure_text(const char *id, const char *name){
+	unsigned char text[32];
+
+	if(id == NULL){
+		memset(text, 0, sizeof(text));
+	} else{
+		memcpy(text, id, 16);
+		memcpy(text + 16, name, 16);
+	}
+
+	dev_write(DEV_FPGA_TEXT, text, 32);
+}
+
+// Sequencer thread, every step is aligned to absolute deadline of timerfd
+static void *figure_sequence(void *arg){
+	struct itimerspec its;
+	struct pollfd fds[2];
+	unsigned long long expired;
+	long long interval;
+	JNIEnv *env;
+	char value;
+	int i, tfd;
+
+	(*seq.vm)->AttachCurrentThread(seq.vm, &env, NULL);
+
+	// Periodic timer with absolute first deadline (no drift)
+	if((tfd = timerfd_create(CLOCK_MONOTONIC, 0)) < 0)
+		perror("timerfd_create error");
+	interval = (long long)seq.time * 100000000LL;
+	clock_gettime(CLOCK_MONOTONIC, &its.it_value);
+	its.it_interval.tv_sec = interval / 1000000000LL;
+	its.it_interval.tv_nsec = interval % 1000000000LL;
+	its.it_value.tv_sec += its.it_interval.tv_sec;
+	its.it_value.tv_nsec += its.it_interval.tv_nsec;
+	if(its.it_value.tv_nsec >= 1000000000L){
+		its.it_value.tv_sec++;
+		its.it_value.tv_nsec -= 1000000000L;
+	}
+	timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
+
+	fds[0].fd = tfd;
+	fds[0].events = POLLIN;
+	fds[1].fd = seq.stop_fd;
+	fds[1].events = POLLIN;
+
+	i = 0;
+	while(i < seq.num){
+		// Print current step and report it
+		value = figure_print(seq.option, seq.num - i);
+		figure_text(seq.id, seq.name);
+		(*env)->CallVoidMethod(env, seq.obj, seq.callback, seq.num - i, (jint)value);
+
+		// Wait for next deadline or stop request
+		if(poll(fds, 2, -1) < 0 && errno != EINTR)
+			break;
+		if(fds[1].revents & POLLIN)
+			break;
+		if(read(tfd, &expired, sizeof(expired)) != sizeof(expired))
+			continue;
+
+		// Catch up missed deadlines so that steps stay on schedule
+		for(; expired > 0 && i < seq.num; expired--){
+			figure_next(seq.option);
+			figure_scroll(seq.id, &seq.id_flag);
+			figure_scroll(seq.name, &seq.name_flag);
+			i++;
+		}
+	}
+
+	// Turn off devices when finished
+	figure_print("0000", 0);
+	figure_text(NULL, NULL);
+	(*env)->CallVoidMethod(env, seq.obj, seq.callback, 0, 0);
+
+	close(tfd);
+
+	(*env)->DeleteGlobalRef(env, seq.obj);
+	(*seq.vm)->DetachCurrentThread(seq.vm);
+
+	seq.running = 0;
+
+	return NULL;
+}
+
+void Java_com_example_androidex_FigureActivity_SequenceStart (JNIEnv *env, jobject thiz, jint time, jint num, jstring option){
+	unsigned long long temp;
+
+	trace_call(TRACE_SEQUENCE_START);
+
+	pthread_mutex_lock(&seq_lock);
+
+	// Only one sequence at a time
+	if(!__sync_bool_compare_and_swap(&seq.running, 0, 1)){
+		pthread_mutex_unlock(&seq_lock);
+		return;
+	}
+	if(seq.joinable){
+		pthread_join(seq.thread, NULL);
+		seq.joinable = 0;
+	}
+
+	if(seq.stop_fd < 0)
+		seq.stop_fd = eventfd(0, EFD_NONBLOCK);
+	else	// drain previous stop request
+		read(seq.stop_fd, &temp, sizeof(temp));
+
+	const char *str = (*env)->GetStringUTFChars(env, option, 0);
+	strncpy(seq.option, str, 4);
+	seq.option[4] = '\0';
+	(*env)->ReleaseStringUTFChars(env, option, str);
+
+	seq.time = time;
+	seq.num = num;
+	memcpy(seq.id, "20091648        ", 16);
+	memcpy(seq.name, "Lee Jun Ho      ", 16);
+	seq.id_flag = 1;
+	seq.name_flag = 1;
+
+	(*env)->GetJavaVM(env, &seq.vm);
+	seq.obj = (*env)->NewGlobalRef(env, thiz);
+	seq.callback = (*env)->GetMethodID(env, (*env)->GetObjectClass(env, thiz), "onSequence", "(II)V");
+
+	if(pthread_create(&seq.thread, NULL, figure_sequence, NULL) != 0){
+		(*env)->DeleteGlobalRef(env, seq.obj);
+		seq.running = 0;
+	} else
+		seq.joinable = 1;
+
+	pthread_mutex_unlock(&seq_lock);
+}
+
+void Java_com_example_androidex_FigureActivity_SequenceStop (JNIEnv *env, jobject thiz){
+	unsigned long long one = 1;
+
+	trace_call(TRACE_SEQUENCE_STOP);
+
+	pthread_mutex_lock(&seq_lock);
+
+	// Wake up sequencer and wait until devices are turned off
+	if(seq.joinable){
+		write(seq.stop_fd, &one, sizeof(one));
+		pthread_join(seq.thread, NULL);
+		seq.joinable = 0;
+	}
+
+	pthread_mutex_unlock(&seq_lock);
+}
+
 void Java_com_example_androidex_FigureActivity_TextPrint (JNIEnv *env, jobject thiz, jstring id, jstring name){
 	unsigned char text[32];
-	int i, fpga_text;
+	int i;
 
-	// Open fpga text lcd driver
-	if((fpga_text = open("/dev/fpga_text_lcd", O_WRONLY)) < 0)
-		perror("/dev/fpga_text_lcd open error");
+	trace_call(TRACE_TEXT_PRINT);
 
 	// Conver jstring to c string
 	const char *student_id = (*env)->GetStringUTFChars(env, id, 0);
@@ -173,22 +362,21 @@ void Java_com_example_androidex_FigureActivity_TextPrint (JNIEnv *env, jobject t
 		}
 	}
 
-	write(fpga_text, text, 32);
+	dev_write(DEV_FPGA_TEXT, text, 32);
 
-	close(fpga_text);
+	(*env)->ReleaseStringUTFChars(env, id, student_id);
+	(*env)->ReleaseStringUTFChars(env, name, student_name);
 }
 
 jstring Java_com_example_androidex_FigureActivity_PushSwitch (JNIEnv *env, jobject thiz){
-	int switch_dev, i;
+	int i;
 	unsigned char push_sw[9];
 	unsigned char temp[10];
 
-	// Open fpga push switch driver
-	if((switch_dev = open("/dev/fpga_push_switch", O_RDWR)) < 0)
-			perror("/dev/fpga_push_switch open error");
+	trace_call(TRACE_FIGURE_PUSH_SWITCH);
 
-	// Read switch input
-	read(switch_dev, &push_sw, 9);
+	// Get switch input polled by device thread
+	dev_switch(push_sw);
 
 	// Copy to char array
 	for (i = 0; i < 9; i++) {
@@ -199,7 +387,5 @@ jstring Java_com_example_androidex_FigureActivity_PushSwitch (JNIEnv *env, jobje
 	}
 	temp[9] = '\0';
 
-	close(switch_dev);
-
 	return (*env)->NewStringUTF(env, temp);
 }
@@ -0,0 +1,229 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <jni.h>
+#include "T9.h"
+#include "Trace.h"
+
+// dictionary and word being typed of TextActivity
+static struct t9_dict dict;
+static struct t9_state word;
+
+// same layout as multi-tap typing
+const char t9_letters[T9_KEYS][4] = {
+	".qz", "abc", "def", "ghi", "jkl", "mno", "prs", "tuv", "wxy"
+};
+
+// every table index is checked once here, lookups trust them after
+static int t9_check(const struct t9_dict *dict){
+	const struct t9_header *head = dict->head;
+	const struct t9_node *n;
+	uint32_t i;
+
+	// every word ends inside string pool
+	if(dict->str_size == 0 || dict->str[dict->str_size - 1] != '\0')
+		return -1;
+	for(i=0;i<head->cands;i++)
+		if(dict->cand[i] >= dict->str_size)
+			return -1;
+
+	// children after their parent (no loop) and inside node table
+	for(i=0;i<head->nodes;i++){
+		n = &dict->node[i];
+		if((n->keys >> T9_KEYS) != 0 || n->cands > T9_CAND
+				|| (uint64_t)n->cand + n->cands > head->cands
+				|| (n->best != T9_NONE && n->best >= dict->str_size))
+			return -1;
+		if(n->keys != 0 && (n->child <= i
+				|| (uint64_t)n->child + __builtin_popcount(n->keys) > head->nodes))
+			return -1;
+	}
+
+	return 0;
+}
+
+// map dictionary file, nothing is allocated, tables are checked once
+int t9_open(struct t9_dict *dict, const char *path){
+	const struct t9_header *head;
+	struct stat st;
+	void *map;
+	int fd;
+
+	if((fd = open(path, O_RDONLY)) < 0)
+		return -1;
+	if(fstat(fd, &st) < 0 || st.st_size < sizeof(struct t9_header)){
+		close(fd);
+		return -1;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+		return -1;
+
+	// node table, candidate table and string pool must lie inside the file
+	head = map;
+	dict->head = head;
+	if(head->magic != T9_MAGIC || head->size != st.st_size || head->nodes == 0
+			|| (uint64_t)head->nodes * sizeof(struct t9_node) + (uint64_t)head->cands * sizeof(uint32_t)
+				+ sizeof(struct t9_header) > head->strings
+			|| head->strings > head->size)
+		goto fail;
+	dict->node = (const struct t9_node *)(head + 1);
+	dict->cand = (const uint32_t *)(dict->node + head->nodes);
+	dict->str = (const char *)map + head->strings;
+	dict->str_size = head->size - head->strings;
+	if(t9_check(dict) < 0)
+		goto fail;
+
+	return 0;
+
+fail:
+	munmap(map, st.st_size);
+	dict->head = NULL;
+	return -1;
+}
+
+void t9_close(struct t9_dict *dict){
+	if(dict->head != NULL)
+		munmap((void *)dict->head, dict->head->size);
+	dict->head = NULL;
+}
+
+void t9_reset(struct t9_state *st){
+	st->len = 0;
+	st->cand = 0;
+	st->node[0] = 0;
+}
+
+// push key (0 ~ 8), one child lookup
+int t9_key(const struct t9_dict *dict, struct t9_state *st, int key){
+	uint32_t node = st->node[st->len];
+	const struct t9_node *n;
+
+	if(st->len >= T9_WORD || key < 0 || key >= T9_KEYS)
+		return -1;
+
+	if(node != T9_NONE){
+		n = &dict->node[node];
+		if(n->keys & (1 << key))
+			node = n->child + __builtin_popcount(n->keys & ((1 << key) - 1));
+		else
+			node = T9_NONE;
+	}
+
+	st->keys[st->len++] = key;
+	st->node[st->len] = node;
+	st->cand = 0;
+
+	return st->len;
+}
+
+// pop last key, node of previous key is kept
+int t9_back(const struct t9_dict *dict, struct t9_state *st){
+	if(st->len > 0)
+		st->len--;
+	st->cand = 0;
+
+	return st->len;
+}
+
+// cycle through words of same key sequence
+int t9_next(const struct t9_dict *dict, struct t9_state *st){
+	uint32_t node = st->node[st->len];
+	int count;
+
+	if(node == T9_NONE)
+		return 0;
+
+	count = dict->node[node].cands;
+	if(count > 0)
+		st->cand = (st->cand + 1) % count;
+
+	return count;
+}
+
+// first len letters of word, none if word is shorter (damaged file)
+static int t9_copy(const struct t9_dict *dict, uint32_t at, int len, char *out){
+	if(strnlen(dict->str + at, len) < len)
+		return 0;
+	memcpy(out, dict->str + at, len);
+	return 1;
+}
+
+int t9_text(const struct t9_dict *dict, const struct t9_state *st, char *out){
+	uint32_t node = st->node[st->len];
+	const struct t9_node *n;
+	int i;
+
+	// word of this key sequence, else start of longer word
+	if(node != T9_NONE){
+		n = &dict->node[node];
+		if(st->cand < n->cands && t9_copy(dict, dict->cand[n->cand + st->cand], st->len, out))
+			return st->len;
+		if(n->best != T9_NONE && t9_copy(dict, n->best, st->len, out))
+			return st->len;
+	}
+
+	// not in dictionary, first letter of each key
+	for(i=0;i<st->len;i++)
+		out[i] = t9_letters[st->keys[i]][0];
+
+	return st->len;
+}
+
+// current prediction as java string (lowercase)
+static jstring t9_word(JNIEnv *env){
+	char text[T9_WORD + 1];
+	int len;
+
+	len = t9_text(&dict, &word, text);
+	text[len] = '\0';
+
+	return (*env)->NewStringUTF(env, text);
+}
+
+jboolean Java_com_example_androidex_TextActivity_T9Open (JNIEnv *env, jobject thiz, jstring path){
+	const char *str;
+	int ret = 0;
+
+	t9_reset(&word);
+	if(dict.head != NULL)
+		return JNI_TRUE;
+
+	str = (*env)->GetStringUTFChars(env, path, 0);
+	ret = t9_open(&dict, str);
+	(*env)->ReleaseStringUTFChars(env, path, str);
+
+	return ret == 0 ? JNI_TRUE : JNI_FALSE;
+}
+
+// switch 1 ~ 9 pressed, returns word for keys so far
+jstring Java_com_example_androidex_TextActivity_T9Key (JNIEnv *env, jobject thiz, jint key){
+	trace_call(TRACE_T9_KEY);
+
+	if(dict.head == NULL)
+		return NULL;
+
+	// word is too long to predict, start new one
+	if(word.len == T9_WORD)
+		t9_reset(&word);
+	t9_key(&dict, &word, key);
+
+	return t9_word(env);
+}
+
+jstring Java_com_example_androidex_TextActivity_T9Next (JNIEnv *env, jobject thiz){
+	if(dict.head == NULL)
+		return NULL;
+
+	t9_next(&dict, &word);
+	return t9_word(env);
+}
+
+// word is kept as typed, next key starts new word
+void Java_com_example_androidex_TextActivity_T9Reset (JNIEnv *env, jobject thiz){
+	t9_reset(&word);
+}
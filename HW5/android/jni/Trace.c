@@ -0,0 +1,201 @@
+#include <jni.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "Trace.h"
+
+#define REPORT_SIZE 4096	// dumpStats text, ends early when full
+
+// Latency statistics of one device
+struct trace_latency{
+	unsigned int count;
+	unsigned long long total;	// ns
+	unsigned long long max;		// ns
+	unsigned int hist[TRACE_BUCKETS];
+};
+
+// Per thread counters, only written by its own thread
+struct trace_buf{
+	struct trace_buf *next;
+	unsigned int calls[TRACE_ENTRIES];
+	struct trace_latency writes[DEV_COUNT];
+	struct trace_latency reads[DEV_COUNT];
+};
+
+static const char *entry_name[TRACE_ENTRIES] = {
+	"FigureSwitch", "TextPrint", "Figure.PushSwitch", "SequenceStart",
+	"SequenceStop", "btnSwitch", "printNumber", "PuzzleCount",
+	"PuzzleScoring", "TextEditor", "Text.PushSwitch", "Watch",
+	"WatchFND", "WatchControl", "T9Key", "WatchElapsed"
+};
+
+static const char *device_name[DEV_COUNT] = {
+	"fnd_driver", "led_driver", "fpga_led", "fpga_dot",
+	"fpga_fnd", "fpga_text_lcd", "fpga_push_switch"
+};
+
+static pthread_key_t trace_key;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct trace_buf *trace_list;	// all buffers (never freed)
+
+static void trace_init(void){
+	pthread_key_create(&trace_key, NULL);
+}
+
+// Get buffer of calling thread, register new one on first use
+static struct trace_buf *trace_get(void){
+	struct trace_buf *buf;
+
+	pthread_once(&trace_once, trace_init);
+	if((buf = pthread_getspecific(trace_key)) != NULL)
+		return buf;
+
+	if((buf = calloc(1, sizeof(*buf))) == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&trace_lock);
+	buf->next = trace_list;
+	trace_list = buf;
+	pthread_mutex_unlock(&trace_lock);
+
+	pthread_setspecific(trace_key, buf);
+
+	return buf;
+}
+
+static unsigned long long trace_now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void trace_record(struct trace_latency *lat, unsigned long long ns){
+	unsigned long long us = ns / 1000;
+	int bucket = 0;
+
+	while(us > 1 && bucket < TRACE_BUCKETS - 1){
+		us >>= 1;
+		bucket++;
+	}
+
+	lat->count++;
+	lat->total += ns;
+	if(ns > lat->max)
+		lat->max = ns;
+	lat->hist[bucket]++;
+}
+
+void trace_call(enum trace_entry entry){
+	struct trace_buf *buf = trace_get();
+
+	if(buf != NULL)
+		buf->calls[entry]++;
+}
+
+ssize_t trace_write(enum fpga_device dev, int fd, const void *data, size_t count){
+	struct trace_buf *buf = trace_get();
+	unsigned long long start;
+	ssize_t ret;
+
+	start = trace_now();
+	ret = write(fd, data, count);
+	if(buf != NULL)
+		trace_record(&buf->writes[dev], trace_now() - start);
+
+	return ret;
+}
+
+ssize_t trace_read(enum fpga_device dev, int fd, void *data, size_t count){
+	struct trace_buf *buf = trace_get();
+	unsigned long long start;
+	ssize_t ret;
+
+	start = trace_now();
+	ret = read(fd, data, count);
+	if(buf != NULL)
+		trace_record(&buf->reads[dev], trace_now() - start);
+
+	return ret;
+}
+
+static void trace_merge(struct trace_latency *sum, const struct trace_latency *lat){
+	int i;
+
+	sum->count += lat->count;
+	sum->total += lat->total;
+	if(lat->max > sum->max)
+		sum->max = lat->max;
+	for(i=0;i<TRACE_BUCKETS;i++)
+		sum->hist[i] += lat->hist[i];
+}
+
+// Length snprintf kept in room bytes, a full buffer ends the report
+static int trace_fit(int len, int room){
+	if(len < 0)
+		return 0;
+	return len < room ? len : room - 1;
+}
+
+// Print one latency line with median / p99 taken from histogram buckets
+static int trace_print(char *out, int room, const char *op, const char *name, const struct trace_latency *lat){
+	unsigned int seen = 0, p50 = 0, p99 = 0;
+	int i, len;
+
+	for(i=0;i<TRACE_BUCKETS;i++){
+		seen += lat->hist[i];
+		if(p50 == 0 && seen * 2 >= lat->count)
+			p50 = 1u << i;
+		if(p99 == 0 && seen * 100 >= lat->count * 99)
+			p99 = 1u << i;
+	}
+
+	len = trace_fit(snprintf(out, room, "%s %-16s n %u avg %lluus p50 <%uus p99 <%uus max %lluus |",
+			op, name, lat->count, lat->total / lat->count / 1000,
+			p50, p99, lat->max / 1000), room);
+	for(i=0;i<TRACE_BUCKETS;i++)
+		len += trace_fit(snprintf(out + len, room - len, " %u", lat->hist[i]), room - len);
+	len += trace_fit(snprintf(out + len, room - len, "\n"), room - len);
+
+	return len;
+}
+
+// Merge all thread buffers and return report
+jstring Java_com_example_androidex_Trace_dumpStats (JNIEnv *env, jclass clazz){
+	struct trace_buf sum, *buf;
+	char report[REPORT_SIZE];
+	int i, len = 0;
+
+	memset(&sum, 0, sizeof(sum));
+	report[0] = '\0';	// nothing traced yet
+
+	// Counters are plain words, a dump may miss calls in flight
+	pthread_mutex_lock(&trace_lock);
+	for(buf=trace_list;buf!=NULL;buf=buf->next){
+		for(i=0;i<TRACE_ENTRIES;i++)
+			sum.calls[i] += buf->calls[i];
+		for(i=0;i<DEV_COUNT;i++){
+			trace_merge(&sum.writes[i], &buf->writes[i]);
+			trace_merge(&sum.reads[i], &buf->reads[i]);
+		}
+	}
+	pthread_mutex_unlock(&trace_lock);
+
+	for(i=0;i<TRACE_ENTRIES && len < REPORT_SIZE - 1;i++)
+		if(sum.calls[i] != 0)
+			len += trace_fit(snprintf(report + len, REPORT_SIZE - len, "call  %-17s %u\n",
+					entry_name[i], sum.calls[i]), REPORT_SIZE - len);
+
+	for(i=0;i<DEV_COUNT && len < REPORT_SIZE - 1;i++){
+		if(sum.writes[i].count != 0)
+			len += trace_print(report + len, REPORT_SIZE - len, "write", device_name[i], &sum.writes[i]);
+		if(sum.reads[i].count != 0 && len < REPORT_SIZE - 1)
+			len += trace_print(report + len, REPORT_SIZE - len, "read ", device_name[i], &sum.reads[i]);
+	}
+
+	return (*env)->NewStringUTF(env, report);
+}
@@ -0,0 +1,38 @@
+/* Hot path tracer of dangercloz_module
+   call count of each JNI entry point and latency histogram
+   of every device read / write (kept per thread, merged on dumpStats) */
+
+#ifndef __DANGERCLOZ_TRACE__
+#define __DANGERCLOZ_TRACE__
+
+#include <sys/types.h>
+#include "Device.h"
+
+// JNI entry points
+enum trace_entry{
+	TRACE_FIGURE_SWITCH,
+	TRACE_TEXT_PRINT,
+	TRACE_FIGURE_PUSH_SWITCH,
+	TRACE_SEQUENCE_START,
+	TRACE_SEQUENCE_STOP,
+	TRACE_MODE_SWITCH,
+	TRACE_PRINT_NUMBER,
+	TRACE_PUZZLE_COUNT,
+	TRACE_PUZZLE_SCORING,
+	TRACE_TEXT_EDITOR,
+	TRACE_TEXT_PUSH_SWITCH,
+	TRACE_WATCH,
+	TRACE_WATCH_FND,
+	TRACE_WATCH_CONTROL,
+	TRACE_T9_KEY,
+	TRACE_WATCH_ELAPSED,
+	TRACE_ENTRIES
+};
+
+#define TRACE_BUCKETS 16	// latency histogram (1us << bucket)
+
+void trace_call(enum trace_entry entry);
+ssize_t trace_write(enum fpga_device dev, int fd, const void *buf, size_t count);
+ssize_t trace_read(enum fpga_device dev, int fd, void *buf, size_t count);
+
+#endif
@@ -5,14 +5,34 @@
 #include <fcntl.h>
 #include <dirent.h>
 #include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "Device.h"
+#include "Trace.h"
+#include "stopwatch_page.h"
+
+// state page of stopwatch module (assignment #3), NULL if not loaded
+static const struct stopwatch_page *watch_page;
+static pthread_once_t watch_once = PTHREAD_ONCE_INIT;
+
+static void watch_map(void){
+	void *map;
+	int fd;
+
+	if((fd = open("/dev/stopwatch", O_RDONLY)) < 0)
+		return;
+	map = mmap(NULL, sizeof(struct stopwatch_page), PROT_READ, MAP_SHARED, fd, 0);
+	if(map != MAP_FAILED)
+		watch_page = map;
+	close(fd);
+}
 
 void JNICALL Java_com_example_androidex_WatchActivity_Watch (JNIEnv *env, jobject thiz, jstring jdate, jstring jtime){
 	unsigned char text[32];
-	int text_dev, i;
+	int i;
 
-	// Open fpga text lcd driver
-	if((text_dev = open("/dev/fpga_text_lcd", O_WRONLY)) < 0)
-		perror("/dev/fpga_text_lcd open error");
+	trace_call(TRACE_WATCH);
 
 	// Convert jstring to c string
 	const char *date = (*env)->GetStringUTFChars(env, jdate, 0);
@@ -28,39 +48,36 @@ void JNICALL Java_com_example_androidex_WatchActivity_Watch (JNIEnv *env, jobjec
 		}
 	}
 
-	write(text_dev, text, 32);
+	dev_write(DEV_FPGA_TEXT, text, 32);
 
-	close(text_dev);
+	(*env)->ReleaseStringUTFChars(env, jdate, date);
+	(*env)->ReleaseStringUTFChars(env, jtime, time);
 }       
 
 void JNICALL Java_com_example_androidex_WatchActivity_WatchFND (JNIEnv *env, jobject thiz, jstring jtime){
-	int fpga_fnd, i;
+	int i;
 	unsigned char data[4];
 
-	// Open fpga fnd driver
-	if((fpga_fnd = open("/dev/fpga_fnd", O_WRONLY)) < 0)
-		perror("/dev/fpga_fnd open error");
+	trace_call(TRACE_WATCH_FND);
 
 	const char *date = (*env)->GetStringUTFChars(env, jtime, 0);
 	for(i=0;i<4;i++)
 		data[i] = date[i];
 
-	write(fpga_fnd, &data, 4);
+	dev_write(DEV_FPGA_FND, &data, 4);
 
-	close(fpga_fnd);
+	(*env)->ReleaseStringUTFChars(env, jtime, date);
 }
 
 jstring JNICALL Java_com_example_androidex_WatchActivity_WatchControl (JNIEnv *env, jobject thiz){
-	int switch_dev, i;
+	int i;
 	unsigned char push_sw[9];
 	unsigned char temp[10];
 
-	// Open fpga push switch driver
-	if((switch_dev = open("/dev/fpga_push_switch", O_RDWR)) < 0)
-		perror("/dev/fpga_push_switch open error");
+	trace_call(TRACE_WATCH_CONTROL);
 
-	// Read switch input
-	read(switch_dev, &push_sw, 9);
+	// Get switch input polled by device thread
+	dev_switch(push_sw);
 
 	// Copy to char array
 	for(i=0;i<9;i++){
@@ -71,7 +88,19 @@ jstring JNICALL Java_com_example_androidex_WatchActivity_WatchControl (JNIEnv *e
 	}
 	temp[9] = '\0';
 
-	close(switch_dev);
-
 	return (*env)->NewStringUTF(env, temp);
 }
+
+// Elapsed ms of stopwatch module read from shared page, -1 if not loaded
+jlong JNICALL Java_com_example_androidex_WatchActivity_WatchElapsed (JNIEnv *env, jobject thiz){
+	struct timespec now;
+
+	trace_call(TRACE_WATCH_ELAPSED);
+
+	pthread_once(&watch_once, watch_map);
+	if(watch_page == NULL)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return stopwatch_elapsed(watch_page, now.tv_sec * 1000000000LL + now.tv_nsec, NULL) / 1000000;
+}
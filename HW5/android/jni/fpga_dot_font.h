@@ -1,41 +0,0 @@
-/* This file is FPGA-DOT MATRIX font file.
-   FILE : fpga_dot_font.h
-   AUTH : Hong, Sung-Hyun
-          Huins, Inc. */
-
-#ifndef __FPGA_NUMBER__
-#define __FPGA_NUMBER__
-
-unsigned char fpga_number[19][10] = {
-	{0x3e,0x7f,0x63,0x73,0x73,0x6f,0x67,0x63,0x7f,0x3e}, // 0
-	{0x0c,0x1c,0x1c,0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x1e}, // 1
-	{0x7e,0x7f,0x03,0x03,0x3f,0x7e,0x60,0x60,0x7f,0x7f}, // 2
-	{0xfe,0x7f,0x03,0x03,0x7f,0x7f,0x03,0x03,0x7f,0x7e}, // 3
-	{0x66,0x66,0x66,0x66,0x66,0x66,0x7f,0x7f,0x06,0x06}, // 4
-	{0x7f,0x7f,0x60,0x60,0x7e,0x7f,0x03,0x03,0x7f,0x7e}, // 5
-	{0x60,0x60,0x60,0x60,0x7e,0x7f,0x63,0x63,0x7f,0x3e}, // 6
-	{0x7f,0x7f,0x63,0x63,0x03,0x03,0x03,0x03,0x03,0x03}, // 7
-	{0x3e,0x7f,0x63,0x63,0x7f,0x7f,0x63,0x63,0x7f,0x3e}, // 8
-	{0x3e,0x7f,0x63,0x63,0x7f,0x3f,0x03,0x03,0x03,0x03}, // 9
-	{0x3E,0x7F,0x63,0x63,0x63,0x7F,0x7F,0x63,0x63,0x63}, // A
-	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63}, // H
-	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f}, // E
-	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f}, // L
-	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60}, // P
-	{0x63,0x77,0x7f,0x7f,0x6B,0x63,0x63,0x63,0x63,0x63}, // M
-	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f}, // E
-	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c}, // !
-	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41} // :-(
-};
-
-unsigned char fpga_set_full[10] = {
-	// memset(array,0x7e,sizeof(array));
-	0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f
-};
-
-unsigned char fpga_set_blank[10] = {
-	// memset(array,0x00,sizeof(array));
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
-};
-
-#endif
@@ -0,0 +1,16 @@
+/* Push switch events of fpga_core (/dev/fpga_push_event)
+   read() returns whole events, blocks until one is queued
+   (O_NONBLOCK gives EAGAIN), poll/epoll report POLLIN while queued */
+
+#ifndef __FPGA_SWITCH__
+#define __FPGA_SWITCH__
+
+struct fpga_switch_event{
+	unsigned int sec;	// CLOCK_MONOTONIC time of edge
+	unsigned int usec;
+	unsigned char sw;	// switch 0 ~ 8
+	unsigned char value;	// 1 press, 0 release
+	unsigned short pad;
+};
+
+#endif
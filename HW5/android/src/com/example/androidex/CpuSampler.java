@@ -0,0 +1,31 @@
+package com.example.androidex;
+
+// Native CPU usage sampler shared by activities
+public class CpuSampler {
+	static {
+		// Load C library
+		System.loadLibrary("dangercloz_module");
+	}
+
+	// Start sampling /proc/stat every interval ms (minimum 10 ms)
+	public static native void start(int interval);
+	public static native void stop();
+
+	// Usage of last interval in percent, [0] is total and [1..] is each cpu
+	public static native int[] usage();
+
+	// Register calling thread for per-thread profiling
+	public static native int watch(String name);
+
+	// Per cpu, per thread and context switch report of recent history
+	public static native String profile();
+
+	// Usage of total cpu, -1 if no sample yet
+	public static int total() {
+		int[] usages = usage();
+
+		if (usages.length == 0)
+			return -1;
+		return usages[0];
+	}
+}
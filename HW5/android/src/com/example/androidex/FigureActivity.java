@@ -1,8 +1,5 @@
 package com.example.androidex;
 
-import java.io.BufferedReader;
-import java.io.FileReader;
-import java.io.IOException;
 import java.util.regex.Pattern;
 
 import android.app.Activity;
@@ -20,14 +17,15 @@ public class FigureActivity extends Activity {
 	public native void FigureSwitch(String option, String left);
 	public native void TextPrint(String id, String name);
 	public native String PushSwitch();
+	public native void SequenceStart(int time, int num, String option);
+	public native void SequenceStop();
 
 	LinearLayout linear;
 	OnClickListener go_listener, main_listener, clear_listener;
 	EditText input;
 	TextView usage, textchar;
 	int time, num;
-	String option, temp;
-	hwThread thread;
+	String option;
 	usageThread usage_thread;
 	getSwitch switch_thread;
 	Button btn_go, btn_main, btn_clear;
@@ -42,7 +40,6 @@ public class FigureActivity extends Activity {
 		System.loadLibrary("dangercloz_module");
 		
 		// Initialize threads
-		thread = new hwThread();
 		usage_thread = new usageThread();
 		switch_thread = new getSwitch();
 		switch_thread.setDaemon(true);
@@ -100,10 +97,7 @@ public class FigureActivity extends Activity {
 
 						// Start only when both time and num are not 0
 						if (time != 0 && num != 0 && option_ok == true) {
-							if(!thread.isAlive()){
-								thread.setDaemon(true);
-								thread.start();
-							}
+							SequenceStart(time, num, option); // Runs on native timer
 							
 							if(!usage_thread.isAlive()){
 								usage_thread.setDaemon(true);
@@ -118,11 +112,10 @@ public class FigureActivity extends Activity {
 		main_listener = new OnClickListener() {
 			@Override
 			public void onClick(View v) {
-				if(thread.isAlive())
-					thread.stop();
+				SequenceStop();
 				
 				if(usage_thread.isAlive())
-					usage_thread.stop();
+					usage_thread.flag = false;
 				
 				switch_thread.flag = false;
 				
@@ -133,10 +126,7 @@ public class FigureActivity extends Activity {
 		clear_listener = new OnClickListener() {
 			@Override
 			public void onClick(View v) {
-				if(thread.isAlive()){
-					thread.i = num;
-					thread = new hwThread();
-				}
+				SequenceStop();
 				
 				if(usage_thread.isAlive()){
 					usage_thread.flag = false;
@@ -153,105 +143,17 @@ public class FigureActivity extends Activity {
 		btn_clear.setOnClickListener(clear_listener);
 	}
 
-	class hwThread extends Thread {
-		int i, flag1 = 1, flag2 = 1;
-		String student_id = "20091648        ";
-		String student_name = "Lee Jun Ho      ";
-		
-		public void run() {
-			int j = 0;
-			i = 0;
-
-			// Run while num is bigger than i
-			while (i < num) {
-				char op[] = option.toCharArray(); // Copy string to char array
-
-				try {
-					// Find where the char is
-					for (j = 0; j < 4; j++)
-						if (op[j] != '0')
-							break;
-
-					// Modify index number of char on application
-					temp = String.valueOf(op[j]);
-					runOnUiThread(new Runnable() {
-						@Override
-						public void run() {
-							textchar.setText(temp);
-						}
-					});
-
-					FigureSwitch(option, String.valueOf(num-i)); // Call C library function
-					TextPrint(student_id, student_name);
-					Thread.sleep(time * 100); // Sleep for given time
-					i++;
-
-					// Modify option for given rule
-					if (op[j] != '8') {
-						op[j]++;
-					} else {
-						if (j != 3) {
-							op[j + 1] = '1';
-							op[j] = '0';
-						} else {
-							op[j] = '0';
-							op[0] = '1';
-						}
-					}
-					option = String.copyValueOf(op);
-					
-					// Calculate student id and student name
-					char id[] = student_id.toCharArray();
-					char name[] = student_name.toCharArray();
-					
-					if(flag1 == 1){	// Move string to right
-						for(int k=15;k>0;k--)
-							id[k] = id[k-1];
-						id[0] = ' ';
-						
-						if(id[15] != ' ')	// Change direction
-							flag1 = 0;
-					} else{	// Move string to left
-						for(int k=0;k<15;k++)
-							id[k] = id[k+1];
-						id[15] = ' ';
-						
-						if(id[0] != ' ')	// Change direction
-							flag1 = 1;
-					}
-					
-					if(flag2 == 1){	// Move string to right
-						for(int k=15;k>0;k--)
-							name[k] = name[k-1];
-						name[0] = ' ';
-						
-						if(name[15] != ' ')	// Change direction
-							flag2 = 0;
-					} else{	// Move string to left
-						for(int k=0;k<15;k++)
-							name[k] = name[k+1];
-						name[15] = ' ';
-						
-						if(name[0] != ' ')	// Change direction
-							flag2 = 1;
-					}
-					student_id = String.copyValueOf(id);
-					student_name = String.copyValueOf(name);
-
-				} catch (InterruptedException e) {}
-			}
-
-			FigureSwitch("0000", String.valueOf(0)); // Turn off fnd driver when finished
-			TextPrint("N", "");	// Turn off fpga text driver when finished
-			runOnUiThread(new Runnable() {
-				@Override
-				public void run() {
+	// Called by native sequencer on every step (left is 0 when finished)
+	public void onSequence(final int left, final int value) {
+		runOnUiThread(new Runnable() {
+			@Override
+			public void run() {
+				if (left == 0)
 					textchar.setText("");
-				}
-			});
-			
-			thread = new hwThread();
-		}
+				else
+					textchar.setText(String.valueOf((char) value));
+			}
+		});
 	}
 
 	class usageThread extends Thread {
@@ -259,50 +161,26 @@ public class FigureActivity extends Activity {
 		
 		public void run() {
 			flag = true;
+			CpuSampler.start(1000); // Sample /proc/stat natively
 			
 			while(flag){
 				try {
-					// Modify CPU usage text
+					// Modify CPU usage text (with per cpu / thread profile)
+					final int usage_c = CpuSampler.total();
+					final String profile = CpuSampler.profile();
 					runOnUiThread(new Runnable() {
 						@Override
 						public void run() {
-							try {
-								FileReader fis = new FileReader("/proc/stat");
-								BufferedReader br = new BufferedReader(fis);
-
-								String str = null;
-								String[] columns = null;
-
-								// Read /proc/stat then split strings into tokens
-								str = br.readLine();
-								columns = str.split(" ");
-
-								// Calculate CPU Usage
-								int total_jiffies = 0;
-								int usage_c;
-
-								total_jiffies += Integer.parseInt(columns[2]);
-								total_jiffies += Integer.parseInt(columns[3]);
-								total_jiffies += Integer.parseInt(columns[4]);
-								total_jiffies += Integer.parseInt(columns[5]);
-								usage_c = Integer.parseInt(columns[5]) * 100
-										/ total_jiffies;
-								usage_c = 100 - usage_c;
-
-								// Modify Text
+							if (usage_c >= 0)
 								usage.setText("CPU usage : "
-										+ String.valueOf(usage_c) + "%");
-
-								// Close file and buffer
-								fis.close();
-								br.close();
-							} catch (IOException e) {}
+										+ String.valueOf(usage_c) + "%\n" + profile);
 						}
 					});
 					
 					Thread.sleep(1000);
 				} catch (InterruptedException e) {}
 			}
+			CpuSampler.stop();
 			
 			// Set text to default value
 			runOnUiThread(new Runnable() {
@@ -321,6 +199,7 @@ public class FigureActivity extends Activity {
 		char[] switch_input = new char[9];
 		
 		public void run(){
+			CpuSampler.watch("figure sw");
 			flag = true;
 			
 			while(flag){
@@ -359,16 +238,13 @@ public class FigureActivity extends Activity {
 						
 						if(first == 1 && second == 2){
 							// (2) & (3) switch
-							thread.i = num;
+							SequenceStop();
 							usage_thread.flag = false;
 							switch_thread.flag = false;
 							onBackPressed();
 						} else if(first == 3 && second == 4){
 							// (4) & (5) switch
-							if(thread.isAlive()){
-								thread.i = num;
-								thread = new hwThread();
-							}
+							SequenceStop();
 							
 							if(usage_thread.isAlive()){
 								usage_thread.flag = false;
@@ -446,7 +322,7 @@ public class FigureActivity extends Activity {
 	
 	// If physical back button pressed, clear devices
 	public boolean onKeyDown(int keyCode, android.view.KeyEvent event){
-		thread.i = num;
+		SequenceStop();
 		usage_thread.flag = false;
 		switch_thread.flag = false;
 		
@@ -76,6 +76,7 @@ public class MainActivity extends Activity{
 		quit_listener = new OnClickListener(){
 			@Override
 			public void onClick(View v){				
+				Log.i("dangercloz", Trace.dumpStats()); // device latency report
 				finish();
 				moveTaskToBack(true);
 			}
@@ -121,6 +121,7 @@ public class ModeActivity extends Activity{
 		char[] switch_input = new char[9];
 		
 		public void run(){
+			CpuSampler.watch("mode sw");
 			flag = true;
 			
 			while(true){
@@ -1,9 +1,5 @@
 package com.example.androidex;
 
-import java.io.BufferedReader;
-import java.io.FileReader;
-import java.io.IOException;
-
 import android.annotation.SuppressLint;
 import android.app.Activity;
 import android.os.Bundle;
@@ -21,6 +17,13 @@ public class TextActivity extends Activity{
 
 	public native void TextEditor(String string);
 	public native String PushSwitch();
+	public native boolean T9Open(String path);
+	public native String T9Key(int key);
+	public native String T9Next();
+	public native void T9Reset();
+	
+	// T9 dictionary built by HW1/t9gen, pushed with adb
+	static final String T9_DICT = "/data/local/tmp/t9.dict";
 	
 	LinearLayout linear;
 	Button btn_modify, btn_clear, btn_main, btn_usage;
@@ -28,6 +31,7 @@ public class TextActivity extends Activity{
 	OnClickListener modify_listener, clear_listener, main_listener, usage_listener;
 	getSwitch thread;
 	String insert_text;
+	boolean t9_loaded;
 	
 	@Override
 	protected void onCreate(Bundle savedInstanceState) {
@@ -38,9 +42,12 @@ public class TextActivity extends Activity{
 		// Load C library
 		System.loadLibrary("dangercloz_module");
 		
+		t9_loaded = T9Open(T9_DICT);
+		
 		thread = new getSwitch();
 		thread.setDaemon(true);
 		thread.start();
+		CpuSampler.start(1000);
 		
 		// Initialize objects from view found by ID
 		text = (EditText)findViewById(R.id.text_edit);
@@ -84,6 +91,7 @@ public class TextActivity extends Activity{
 				// Clear board HW and back to Main Activity
 				TextEditor("");
 				thread.flag = false;
+				CpuSampler.stop();
 				onBackPressed();
 			}
 		};
@@ -109,35 +117,11 @@ public class TextActivity extends Activity{
 	Handler mHandler = new Handler(){
 		public void handleMessage(Message msg){
 			if(msg.what == 0){
-				try{
-					FileReader fis = new FileReader("/proc/stat");
-					BufferedReader br = new BufferedReader(fis);
-					
-					String str = null;
-					String[] columns = null;
-					
-					// Read /proc/stat then split strings into tokens
-					str = br.readLine();
-					columns = str.split(" ");
-					
-					// Calculate CPU Usage
-					int total_jiffies = 0;
-					int usage;
-					
-					total_jiffies += Integer.parseInt(columns[2]);
-					total_jiffies += Integer.parseInt(columns[3]);
-					total_jiffies += Integer.parseInt(columns[4]);
-					total_jiffies += Integer.parseInt(columns[5]);
-					usage = Integer.parseInt(columns[5])*100 / total_jiffies;
-					usage = 100 - usage;
-					
-					// Modify Text
+				int usage = CpuSampler.total();
+				
+				// Modify Text
+				if(usage >= 0)
 					usage_text.setText("CPU Usage : " + String.valueOf(usage) + "%");
-					
-					// Close file and buffer
-					fis.close();
-					br.close();
-				} catch (IOException e){}
 			}
 		}
 	};
@@ -146,7 +130,8 @@ public class TextActivity extends Activity{
 		boolean flag = true, zeroes;
 		boolean modified = false;
 		String temp;
-		int num_flag = 1;
+		int num_flag = 1;	// 1 : alphabet, 2 : numeric, 3 : T9
+		int t9_shown = 0;	// characters of predicted word at end of text
 		char[] input = new char[9];
 		char[] temp2;
 		char[][] char_set = {{'.', 'q', 'z'},
@@ -160,6 +145,7 @@ public class TextActivity extends Activity{
 												 {'w', 'x', 'y'}};
 		
 		public void run(){
+			CpuSampler.watch("text sw");
 			while(flag){
 				zeroes = true;
 				
@@ -209,6 +195,8 @@ public class TextActivity extends Activity{
 							onBackPressed();
 						} else if(first == 3 && second == 4){
 							// (4) & (5) switch
+							T9Reset();
+							t9_shown = 0;
 							insert_text = "";
 							TextEditor(insert_text);
 							
@@ -224,8 +212,15 @@ public class TextActivity extends Activity{
 							// (5) & (6) switch
 							if(num_flag == 1)
 								num_flag = 2;
+							else if(num_flag == 2 && t9_loaded)
+								num_flag = 3;
 							else
 								num_flag = 1;
+							T9Reset();
+							t9_shown = 0;
+						} else if(first == 5 && second == 6 && num_flag == 3){
+							// (6) & (7) switch, next word of same keys
+							t9_replace(T9Next());
 						}
 					} else if(count == 1){	// if there is only one input
 						if (num_flag == 1) {
@@ -313,6 +308,13 @@ public class TextActivity extends Activity{
 									modified = true;
 								}
 							});
+						} else if(num_flag == 3){
+							int i;
+							for (i = 0; i < 9; i++)
+								if (input[i] == '1')
+									break;
+							
+							t9_replace(T9Key(i));
 						} else if(num_flag == 2){
 							if (text.length() == 32) {
 								TextEditor("Error. Too large");
@@ -355,12 +357,41 @@ public class TextActivity extends Activity{
 				} catch(InterruptedException e){}
 			}
 		}
+		
+		// replace predicted word at end of text with new prediction
+		void t9_replace(String word){
+			if(word == null)
+				return;
+			
+			insert_text = text.getText().toString();
+			if(insert_text.length() >= t9_shown)
+				insert_text = insert_text.substring(0, insert_text.length() - t9_shown);
+			insert_text += word;
+			t9_shown = word.length();
+			
+			if(insert_text.length() > 32){
+				TextEditor("Error. Too large");
+				insert_text = "Error. Too large";
+				T9Reset();
+				t9_shown = 0;
+			}
+			
+			// print on board text
+			runOnUiThread(new Runnable() {
+				@Override
+				public void run() {
+					text.setText(insert_text);
+					modified = true;
+				}
+			});
+		}
 	}
 	
 	// If physical back button pressed, clear devices
 	public boolean onKeyDown(int keyCode, android.view.KeyEvent event){
 		TextEditor("");
 		thread.flag = false;
+		CpuSampler.stop();
 		
 		return super.onKeyDown(keyCode, event);
 	}
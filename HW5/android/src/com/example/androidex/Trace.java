@@ -0,0 +1,12 @@
+package com.example.androidex;
+
+// Hot path statistics of native module (calls and device latency)
+public class Trace {
+	static {
+		// Load C library
+		System.loadLibrary("dangercloz_module");
+	}
+
+	// Merge per thread counters and return report
+	public static native String dumpStats();
+}
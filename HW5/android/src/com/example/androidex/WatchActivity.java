@@ -21,6 +21,7 @@ public class WatchActivity extends Activity{
 	public native void Watch(String date, String time);
 	public native void WatchFND(String stop);
 	public native String WatchControl();
+	public native long WatchElapsed();
 
 	LinearLayout linear;
 	Button btn_settime, btn_month, btn_day, btn_hour, btn_minute;
@@ -207,6 +208,7 @@ public class WatchActivity extends Activity{
 		int stop_min = 0, stop_sec = 0;
 		
 		public void run(){
+			CpuSampler.watch("stopwatch");
 			while(flag){
 				try{
 					if(pause){}
@@ -221,10 +223,17 @@ public class WatchActivity extends Activity{
 						
 						Thread.sleep(1000);
 						
-						stop_sec++;
-						if(stop_sec > 59){
-							stop_sec = 0;
-							stop_min++;
+						// Follow stopwatch module when it is loaded (read from shared page)
+						long elapsed = WatchElapsed();
+						if(elapsed >= 0){
+							stop_min = (int)(elapsed / 60000 % 60);
+							stop_sec = (int)(elapsed / 1000 % 60);
+						} else{
+							stop_sec++;
+							if(stop_sec > 59){
+								stop_sec = 0;
+								stop_min++;
+							}
 						}
 					}
 				} catch(InterruptedException e){}
@@ -239,6 +248,7 @@ public class WatchActivity extends Activity{
 		char[] switch_input = new char[9];
 		
 		public void run(){
+			CpuSampler.watch("watch sw");
 			flag = true;
 			
 			while(flag){
@@ -0,0 +1,47 @@
+# boot-to-ready time of drivers : sh bootbench.sh [old|core] [runs]
+# loads drivers, waits until every node exists, unloads again
+# (kernel log of fpga_core also reports time spent in module init)
+
+MODE=${1:-core}
+RUNS=${2:-10}
+NODES="fnd_driver led_driver fpga_fnd fpga_led fpga_dot fpga_text_lcd fpga_push_switch"
+
+uptime_ms(){
+	awk '{printf "%d", $1 * 1000}' /proc/uptime
+}
+
+unload(){
+	if [ "$MODE" = "core" ]; then
+		rmmod fpga_core
+	else
+		rmmod fpga_push_switch_driver fpga_dot_driver fpga_led_driver fpga_text_lcd_driver
+		rmmod fpga_fnd_driver led_driver fnd_driver
+		for n in $NODES; do rm -f /dev/$n; done
+	fi
+}
+
+total=0
+i=0
+while [ $i -lt $RUNS ]; do
+	start=$(uptime_ms)
+	if [ "$MODE" = "core" ]; then
+		sh insdev_core.sh > /dev/null 2>&1
+	else
+		sh insdev.sh > /dev/null 2>&1
+	fi
+
+	# ready when every node exists
+	for n in $NODES; do
+		while [ ! -c /dev/$n ]; do
+			usleep 1000
+		done
+	done
+	end=$(uptime_ms)
+
+	echo "$MODE run $i : $((end - start))ms"
+	total=$((total + end - start))
+	unload
+	i=$((i + 1))
+done
+
+echo "$MODE average $((total / RUNS))ms over $RUNS runs (/proc/uptime, 10ms resolution)"
@@ -0,0 +1,1035 @@
+/********************************************
+  2014 Sogang Univ. Embedded System Software
+  FPGA core driver (all board devices in one module)
+  Made by Lee Jun-Ho (dangercloz@gmail.com)
+ ********************************************/
+
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/ioport.h>
+#include <linux/cdev.h>
+#include <linux/device.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/kfifo.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/sched.h>
+#include <linux/mutex.h>
+#include <linux/uaccess.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+
+#include <asm/io.h>
+#include <asm/uaccess.h>
+#include <asm/atomic.h>
+
+#include "./fpga_fb.h"
+#include "./fpga_switch.h"
+#include "./fpga_text.h"
+#include "./fpga_motor.h"
+#include "./fpga_buzzer.h"
+
+#define DEV_NAME "fpga_core"	// core driver name (major is dynamic)
+
+#define UON 0x00	// IOM
+
+// fnd driver device address
+#define FND_GPL2CON 0x11000100	// fnd pin configuration
+#define FND_GPL2DAT 0x11000104	// fnd pin data
+#define FND_GPE3CON 0x11400140	// fnd pin configuration
+#define FND_GPE3DAT 0x11400144	// fnd pin data
+
+// led driver device address
+#define LED_GPBCON 0x11400040	// GPBCON register physical addr
+#define LED_GPBDAT 0x11400044	// GPBDAT register physical addr
+
+// fpga window, every fpga device is an offset of one mapping
+#define IOM_BASE_ADDRESS 0x04000000
+#define IOM_SIZE 0x400
+#define IOM_FND 0x004		// fpga fnd
+#define IOM_LED 0x016		// fpga led
+#define IOM_MOTOR_ACTION 0x00C	// fpga step motor on / off
+#define IOM_MOTOR_DIR 0x00E	// fpga step motor direction
+#define IOM_MOTOR_SPEED 0x010	// fpga step motor speed (larger is slower)
+#define IOM_PUSH_SWITCH 0x050	// fpga push switch (16 bit per switch)
+#define IOM_BUZZER 0x070	// fpga buzzer on / off
+#define IOM_TEXT_LCD 0x100	// fpga text lcd
+#define IOM_DOT 0x210		// fpga dot
+#define IOM_DEMO 0x300		// fpga common factor
+
+#define PUSH_SWITCH 9		// number of push switches
+#define SWITCH_FIFO 64		// events kept until read (power of 2)
+#define MOTOR_QUEUE 8		// moves queued at once
+#define MOTOR_RAMP 256		// longest acceleration (steps)
+
+// sub devices, minor number is index
+enum core_minor{
+	CORE_FND,		// gpio fnd (select << 8 | segments)
+	CORE_LED,		// gpio led
+	CORE_FPGA_FND,
+	CORE_FPGA_LED,
+	CORE_FPGA_DOT,
+	CORE_FPGA_TEXT,
+	CORE_PUSH_SWITCH,
+	CORE_FB,		// shadow page of fpga displays
+	CORE_PUSH_EVENT,	// debounced push switch events
+	CORE_STEP_MOTOR,	// queued moves
+	CORE_BUZZER,		// melody sequencer
+	CORE_DEVICES
+};
+
+// node names are the ones of separate drivers, applications do not change
+static const char *core_name[CORE_DEVICES] = {
+	"fnd_driver", "led_driver", "fpga_fnd", "fpga_led",
+	"fpga_dot", "fpga_text_lcd", "fpga_push_switch", "fpga_fb", "fpga_push_event",
+	"fpga_step_motor", "fpga_buzzer"
+};
+
+int core_open(struct inode *, struct file *);
+int core_release(struct inode *, struct file *);
+int core_mmap(struct file *, struct vm_area_struct *);
+ssize_t core_write(struct file *, const char *, size_t, loff_t *);
+ssize_t core_read(struct file *, char *, size_t, loff_t *);
+unsigned int core_poll(struct file *, poll_table *);
+long core_ioctl(struct file *, unsigned int, unsigned long);
+loff_t core_llseek(struct file *, loff_t, int);
+
+static struct file_operations core_fops =
+{
+	.owner = THIS_MODULE,
+	.open = core_open,
+	.release = core_release,
+	.mmap = core_mmap,
+	.write = core_write,
+	.read = core_read,
+	.poll = core_poll,
+	.unlocked_ioctl = core_ioctl,
+	.llseek = core_llseek,
+};
+
+// refresh rate of fpga displays (flushes per second)
+static int refresh_hz = 60;
+module_param(refresh_hz, int, 0644);
+MODULE_PARM_DESC(refresh_hz, "framebuffer flush rate in Hz");
+
+// push switch scan rate and time a level must hold to count
+static int scan_hz = 1000;
+module_param(scan_hz, int, 0644);
+MODULE_PARM_DESC(scan_hz, "push switch scan rate in Hz");
+static int debounce_ms = 5;
+module_param(debounce_ms, int, 0644);
+MODULE_PARM_DESC(debounce_ms, "push switch debounce time in ms");
+
+// Global variables
+static dev_t core_dev;
+static struct cdev core_cdev;
+static struct class *core_class;
+static int core_usage;			// open files, under usage_mutex
+static DEFINE_MUTEX(usage_mutex);	// first open and last release start and stop engines
+static DEFINE_SPINLOCK(core_lock);	// flush of write() against refresh
+
+// shared refresh engine
+static struct fpga_fb *fb;		// page shared with userspace
+static struct fpga_fb shown;		// last values written to devices
+static struct hrtimer refresh_timer;
+static ktime_t rate_start;		// start of current second
+static unsigned int rate_cells;		// text cells at start of second
+
+// push switch scanner
+static struct hrtimer scan_timer;
+static DECLARE_KFIFO(switch_fifo, struct fpga_switch_event, SWITCH_FIFO);
+static DECLARE_WAIT_QUEUE_HEAD(switch_wq);
+static int scan_usage;			// open event files, under usage_mutex
+static unsigned char switch_state[PUSH_SWITCH];	// debounced level
+static unsigned char switch_raw[PUSH_SWITCH];	// last sample
+static int switch_stable[PUSH_SWITCH];		// samples raw level held
+static ktime_t switch_edge[PUSH_SWITCH];	// time raw level changed
+static unsigned int switch_events, switch_dropped;
+
+// step motor move with precomputed acceleration
+struct motor_move{
+	struct fpga_motor_move move;
+	int ramp;			// steps of acceleration (same for deceleration)
+	unsigned int cruise;		// step interval at speed (us)
+	unsigned int interval[MOTOR_RAMP];	// step interval while accelerating (us)
+};
+
+// step motor queue, ring of moves run by motor timer
+static struct hrtimer motor_timer;
+static struct motor_move motor_queue[MOTOR_QUEUE];
+static int motor_head, motor_count;	// running move, moves queued
+static unsigned int motor_step;		// steps done of running move
+static unsigned int motor_submitted, motor_done;
+static DECLARE_WAIT_QUEUE_HEAD(motor_wq);
+static DEFINE_MUTEX(motor_mutex);	// one writer fills free slot or cancels at a time, never held asleep
+
+// speed register of step interval
+static int motor_us_per_speed = 100;
+module_param(motor_us_per_speed, int, 0644);
+MODULE_PARM_DESC(motor_us_per_speed, "step interval of one step motor speed unit in us");
+
+// melody played by buzzer timer
+static struct hrtimer buzzer_timer;
+static struct fpga_note buzzer_melody[FPGA_BUZZER_NOTES];
+static int buzzer_notes, buzzer_next;	// notes of melody, next note to play
+static DECLARE_WAIT_QUEUE_HEAD(buzzer_wq);
+static DEFINE_MUTEX(buzzer_mutex);	// one writer replaces melody at a time
+
+// gpio global variable
+static unsigned char *fnd_data;
+static unsigned int *fnd_ctrl;
+static unsigned char *fnd_data2;
+static unsigned int *fnd_ctrl2;
+static unsigned char *led_data;
+static unsigned int *led_ctrl;
+
+// fpga global variable
+static unsigned char *iom_addr;		// whole fpga window
+
+// write bytes that differ from device, returns number written
+static int fb_flush_bytes(const unsigned char *data, unsigned char *dev, unsigned int offset, int len){
+	int i, n = 0;
+
+	for(i=0;i<len;i++){
+		if(data[i] == dev[i])
+			continue;
+		dev[i] = data[i];
+		outb(data[i], (unsigned int)iom_addr + offset + i);
+		n++;
+	}
+
+	return n;
+}
+
+// copy dirty regions of page to devices, caller holds core_lock
+static void fb_flush(void){
+	unsigned short fnd_value;
+	int i, n;
+
+	if((n = fb_flush_bytes(fb->dot, shown.dot, IOM_DOT, FPGA_FB_DOT)) > 0){
+		fb->flush[FPGA_FB_REGION_DOT]++;
+		fb->bytes += n;
+	}
+
+	// four digits are one register
+	if(memcmp(fb->fnd, shown.fnd, FPGA_FB_FND) != 0){
+		memcpy(shown.fnd, fb->fnd, FPGA_FB_FND);
+		fnd_value = 0;
+		for(i=0;i<FPGA_FB_FND;i++)
+			fnd_value = (fnd_value << 4) | (shown.fnd[i] & 0x0F);
+		outw(fnd_value, (unsigned int)iom_addr + IOM_FND);
+		fb->flush[FPGA_FB_REGION_FND]++;
+		fb->bytes += sizeof(fnd_value);
+	}
+
+	if((n = fb_flush_bytes(fb->text, shown.text, IOM_TEXT_LCD, FPGA_FB_TEXT)) > 0){
+		fb->flush[FPGA_FB_REGION_TEXT]++;
+		fb->text_cells += n;
+		fb->bytes += n;
+	}
+
+	if(fb_flush_bytes(&fb->led, &shown.led, IOM_LED, 1) > 0){
+		fb->flush[FPGA_FB_REGION_LED]++;
+		fb->bytes++;
+	}
+}
+
+// refresh engine tick (hrtimer interrupt context)
+static enum hrtimer_restart fb_refresh(struct hrtimer *timer){
+	ktime_t now = hrtimer_cb_get_time(timer);
+
+	spin_lock(&core_lock);
+	fb_flush();
+	fb->refresh++;
+	spin_unlock(&core_lock);
+
+	// text lcd cells per second
+	if(ktime_to_us(ktime_sub(now, rate_start)) >= USEC_PER_SEC){
+		fb->text_rate = fb->text_cells - rate_cells;
+		rate_cells = fb->text_cells;
+		rate_start = now;
+	}
+
+	if(refresh_hz < 1)
+		refresh_hz = 1;
+	fb->missed += hrtimer_forward_now(timer, ktime_set(0, NSEC_PER_SEC / refresh_hz)) - 1;
+
+	return HRTIMER_RESTART;
+}
+
+// sample switches, queue level held for debounce time (hrtimer interrupt context)
+static enum hrtimer_restart switch_scan(struct hrtimer *timer){
+	struct fpga_switch_event ev;
+	struct timespec ts;
+	ktime_t now = hrtimer_cb_get_time(timer);
+	unsigned char raw;
+	int i, hold, queued = 0;
+
+	if(scan_hz < 1)
+		scan_hz = 1;
+	hold = debounce_ms * scan_hz / 1000;
+
+	for(i=0;i<PUSH_SWITCH;i++){
+		raw = inw((unsigned int)iom_addr + IOM_PUSH_SWITCH + i * 2) & 0xFF;
+		if(raw != switch_raw[i]){
+			switch_raw[i] = raw;
+			switch_stable[i] = 0;
+			switch_edge[i] = now;
+			continue;
+		}
+		if(raw == switch_state[i] || ++switch_stable[i] < hold)
+			continue;
+
+		// time of edge, not of end of debounce
+		switch_state[i] = raw;
+		ts = ktime_to_timespec(switch_edge[i]);
+		ev.sec = ts.tv_sec;
+		ev.usec = ts.tv_nsec / 1000;
+		ev.sw = i;
+		ev.value = raw ? 1 : 0;
+		ev.pad = 0;
+
+		spin_lock(&core_lock);
+		if(kfifo_in(&switch_fifo, &ev, 1) == 1)
+			switch_events++;
+		else
+			switch_dropped++;
+		spin_unlock(&core_lock);
+		queued = 1;
+	}
+
+	if(queued)
+		wake_up_interruptible(&switch_wq);
+
+	hrtimer_forward_now(timer, ktime_set(0, NSEC_PER_SEC / scan_hz));
+	return HRTIMER_RESTART;
+}
+
+// trapezoid profile, intervals of accelerating steps are computed on submit
+// (c0 = 0.676 sqrt(2 / a), cn = cn-1 - 2 cn-1 / (4n + 1), integer only)
+static void motor_profile(struct motor_move *m){
+	unsigned int c;
+	int n;
+
+	if(m->move.speed < 1)
+		m->move.speed = 1;
+	m->cruise = USEC_PER_SEC / m->move.speed;
+	m->ramp = 0;
+
+	// no acceleration, every step at cruise speed
+	if(m->move.accel == 0)
+		return;
+
+	c = 676 * int_sqrt(2000000 / m->move.accel);
+	for(n=1;n<=MOTOR_RAMP && c > m->cruise && m->ramp * 2 < m->move.steps;n++){
+		m->interval[m->ramp++] = c;
+		c -= 2 * c / (4 * n + 1);
+	}
+}
+
+// start move at head of queue, caller holds core_lock
+static void motor_start(void){
+	struct motor_move *m = &motor_queue[motor_head];
+
+	motor_step = 0;
+	outw(m->move.dir ? 1 : 0, (unsigned int)iom_addr + IOM_MOTOR_DIR);
+	outw(1, (unsigned int)iom_addr + IOM_MOTOR_ACTION);
+	hrtimer_start(&motor_timer, ktime_set(0, 0), HRTIMER_MODE_REL);
+}
+
+// one step of running move (hrtimer interrupt context)
+static enum hrtimer_restart motor_tick(struct hrtimer *timer){
+	struct motor_move *m;
+	unsigned int interval, speed, left;
+
+	spin_lock(&core_lock);
+	m = &motor_queue[motor_head];
+
+	// move finished, next one continues without stopping the timer
+	if(motor_step >= m->move.steps){
+		motor_done++;
+		motor_head = (motor_head + 1) % MOTOR_QUEUE;
+		if(--motor_count == 0){
+			outw(0, (unsigned int)iom_addr + IOM_MOTOR_ACTION);
+			spin_unlock(&core_lock);
+			wake_up_interruptible(&motor_wq);
+			return HRTIMER_NORESTART;
+		}
+		m = &motor_queue[motor_head];
+		motor_step = 0;
+		outw(m->move.dir ? 1 : 0, (unsigned int)iom_addr + IOM_MOTOR_DIR);
+		wake_up_interruptible(&motor_wq);
+	}
+
+	// accelerate, cruise, decelerate on the same table
+	left = m->move.steps - motor_step;
+	if(motor_step < m->ramp)
+		interval = m->interval[motor_step];
+	else if(left <= m->ramp)
+		interval = m->interval[left - 1];
+	else
+		interval = m->cruise;
+	motor_step++;
+
+	if(motor_us_per_speed < 1)
+		motor_us_per_speed = 1;
+	speed = interval / motor_us_per_speed;
+	outw(speed < 1 ? 1 : (speed > 255 ? 255 : speed), (unsigned int)iom_addr + IOM_MOTOR_SPEED);
+	spin_unlock(&core_lock);
+
+	hrtimer_forward_now(timer, ktime_set(interval / USEC_PER_SEC, (interval % USEC_PER_SEC) * NSEC_PER_USEC));
+	return HRTIMER_RESTART;
+}
+
+// queue whole moves, blocks while queue is full unless O_NONBLOCK
+static ssize_t motor_submit(struct file *mfile, const char *gdata, size_t length){
+	struct motor_move *m;
+	struct fpga_motor_move move;
+	unsigned char legacy[3];
+	unsigned long flags;
+	size_t done = 0;
+	int result;
+
+	// old interface sets registers directly, queued moves are dropped
+	if(length == sizeof(legacy)){
+		if(copy_from_user(legacy, gdata, sizeof(legacy)))
+			return -EFAULT;
+		if(mutex_lock_interruptible(&motor_mutex))
+			return -ERESTARTSYS;
+		hrtimer_cancel(&motor_timer);
+		spin_lock_irqsave(&core_lock, flags);
+		motor_done += motor_count;
+		motor_count = 0;
+		outw(legacy[1], (unsigned int)iom_addr + IOM_MOTOR_DIR);
+		outw(legacy[2], (unsigned int)iom_addr + IOM_MOTOR_SPEED);
+		outw(legacy[0], (unsigned int)iom_addr + IOM_MOTOR_ACTION);
+		spin_unlock_irqrestore(&core_lock, flags);
+		mutex_unlock(&motor_mutex);
+		wake_up_interruptible(&motor_wq);
+		return length;
+	}
+
+	if(length < sizeof(move))
+		return -EINVAL;
+
+	while(done + sizeof(move) <= length){
+		if(copy_from_user(&move, gdata + done, sizeof(move)))
+			return done ? done : -EFAULT;
+		if(move.steps == 0){
+			done += sizeof(move);
+			continue;
+		}
+
+		// sleep for room without motor_mutex, a legacy write may cancel meanwhile
+		if(mutex_lock_interruptible(&motor_mutex))
+			return done ? done : -ERESTARTSYS;
+		while(motor_count == MOTOR_QUEUE){
+			mutex_unlock(&motor_mutex);
+			if(done > 0)
+				return done;
+			if(mfile->f_flags & O_NONBLOCK)
+				return -EAGAIN;
+			result = wait_event_interruptible(motor_wq, motor_count < MOTOR_QUEUE);
+			if(result < 0)
+				return result;
+			if(mutex_lock_interruptible(&motor_mutex))
+				return -ERESTARTSYS;
+		}
+
+		// free slot from head and count read together (motor_tick moves both);
+		// it stays free, motor_mutex keeps other writers out and the timer
+		// does not use it until counted, so the profile is built outside of lock
+		spin_lock_irqsave(&core_lock, flags);
+		m = &motor_queue[(motor_head + motor_count) % MOTOR_QUEUE];
+		spin_unlock_irqrestore(&core_lock, flags);
+		m->move = move;
+		motor_profile(m);
+
+		spin_lock_irqsave(&core_lock, flags);
+		motor_submitted++;
+		if(motor_count++ == 0)
+			motor_start();
+		spin_unlock_irqrestore(&core_lock, flags);
+		mutex_unlock(&motor_mutex);
+
+		done += sizeof(move);
+	}
+
+	return done;
+}
+
+static ssize_t motor_read(char *gdata, size_t length){
+	struct fpga_motor_status status;
+	unsigned long flags;
+
+	if(length < sizeof(status))
+		return -EINVAL;
+
+	spin_lock_irqsave(&core_lock, flags);
+	status.submitted = motor_submitted;
+	status.done = motor_done;
+	status.queued = motor_count;
+	status.step = motor_count ? motor_step : 0;
+	spin_unlock_irqrestore(&core_lock, flags);
+
+	if(copy_to_user(gdata, &status, sizeof(status)))
+		return -EFAULT;
+
+	return sizeof(status);
+}
+
+// start next note at its deadline, a whole note costs one timer interrupt
+static enum hrtimer_restart buzzer_tick(struct hrtimer *timer){
+	struct fpga_note *note;
+
+	spin_lock(&core_lock);
+	if(buzzer_next >= buzzer_notes){
+		outw(0, (unsigned int)iom_addr + IOM_BUZZER);
+		buzzer_notes = buzzer_next = 0;
+		spin_unlock(&core_lock);
+		wake_up_interruptible(&buzzer_wq);
+		return HRTIMER_NORESTART;
+	}
+
+	note = &buzzer_melody[buzzer_next++];
+	outw(note->tone ? 1 : 0, (unsigned int)iom_addr + IOM_BUZZER);
+	spin_unlock(&core_lock);
+
+	// forwarded from last deadline, so notes do not drift
+	hrtimer_forward_now(timer, ktime_set(note->ms / MSEC_PER_SEC, (note->ms % MSEC_PER_SEC) * NSEC_PER_MSEC));
+	return HRTIMER_RESTART;
+}
+
+// stop melody and set buzzer, caller holds buzzer_mutex
+static void buzzer_set(int on){
+	unsigned long flags;
+
+	hrtimer_cancel(&buzzer_timer);
+	spin_lock_irqsave(&core_lock, flags);
+	buzzer_notes = buzzer_next = 0;
+	outw(on ? 1 : 0, (unsigned int)iom_addr + IOM_BUZZER);
+	spin_unlock_irqrestore(&core_lock, flags);
+	wake_up_interruptible(&buzzer_wq);
+}
+
+static ssize_t buzzer_write(const char *gdata, size_t length){
+	unsigned char value;
+	unsigned long flags;
+	int notes;
+
+	// old interface turns buzzer on or off
+	if(length == 1){
+		if(copy_from_user(&value, gdata, 1))
+			return -EFAULT;
+		if(mutex_lock_interruptible(&buzzer_mutex))
+			return -ERESTARTSYS;
+		buzzer_set(value);
+		mutex_unlock(&buzzer_mutex);
+		return length;
+	}
+
+	notes = length / sizeof(struct fpga_note);
+	if(notes < 1 || notes > FPGA_BUZZER_NOTES)
+		return -EINVAL;
+
+	if(mutex_lock_interruptible(&buzzer_mutex))
+		return -ERESTARTSYS;
+	buzzer_set(0);
+	if(copy_from_user(buzzer_melody, gdata, notes * sizeof(struct fpga_note))){
+		mutex_unlock(&buzzer_mutex);
+		return -EFAULT;
+	}
+
+	spin_lock_irqsave(&core_lock, flags);
+	buzzer_notes = notes;
+	hrtimer_start(&buzzer_timer, ktime_set(0, 0), HRTIMER_MODE_REL);
+	spin_unlock_irqrestore(&core_lock, flags);
+	mutex_unlock(&buzzer_mutex);
+
+	return notes * sizeof(struct fpga_note);
+}
+
+static long buzzer_ioctl(unsigned int cmd){
+	switch(cmd){
+		case FPGA_BUZZER_WAIT:
+			return wait_event_interruptible(buzzer_wq, buzzer_notes == 0);
+
+		case FPGA_BUZZER_STOP:
+			if(mutex_lock_interruptible(&buzzer_mutex))
+				return -ERESTARTSYS;
+			buzzer_set(0);
+			mutex_unlock(&buzzer_mutex);
+			return 0;
+	}
+
+	return -ENOTTY;
+}
+
+// region of page written through a display device
+static unsigned char *core_region(int minor, int *size){
+	switch(minor){
+		case CORE_FPGA_FND:
+			*size = FPGA_FB_FND;
+			return fb->fnd;
+		case CORE_FPGA_LED:
+			*size = 1;
+			return &fb->led;
+		case CORE_FPGA_DOT:
+			*size = FPGA_FB_DOT;
+			return fb->dot;
+		case CORE_FPGA_TEXT:
+			*size = FPGA_FB_TEXT;
+			return fb->text;
+		case CORE_FB:
+			*size = sizeof(struct fpga_fb);
+			return (unsigned char *)fb;
+	}
+
+	return NULL;
+}
+
+// gpio fnd, blank before changing segments so value does not ghost
+static void fnd_write(unsigned short value){
+	outb(0x00, (unsigned int)fnd_data2);
+	outb(value & 0xFF, (unsigned int)fnd_data);
+	outb(value >> 8, (unsigned int)fnd_data2);
+}
+
+// open sub device, first user starts refresh engine
+int core_open(struct inode *minode, struct file *mfile){
+	int i;
+
+	mfile->private_data = (void *)iminor(minode);
+
+	// count and timer change together, a release can not cancel what this open started
+	if(mutex_lock_interruptible(&usage_mutex))
+		return -ERESTARTSYS;
+
+	if(core_usage++ == 0){
+		rate_start = ktime_get();
+		rate_cells = fb->text_cells;
+		hrtimer_start(&refresh_timer, ktime_set(0, 0), HRTIMER_MODE_REL);
+	}
+
+	// scan while anyone waits for events, current level is not an event
+	if(iminor(minode) == CORE_PUSH_EVENT && scan_usage++ == 0){
+		for(i=0;i<PUSH_SWITCH;i++){
+			switch_raw[i] = inw((unsigned int)iom_addr + IOM_PUSH_SWITCH + i * 2) & 0xFF;
+			switch_state[i] = switch_raw[i];
+			switch_stable[i] = 0;
+		}
+		hrtimer_start(&scan_timer, ktime_set(0, 0), HRTIMER_MODE_REL);
+	}
+	mutex_unlock(&usage_mutex);
+
+	return 0;
+}
+
+// release sub device (mapping holds file until unmapped), last user stops refresh
+int core_release(struct inode *minode, struct file *mfile){
+	mutex_lock(&usage_mutex);
+
+	if(iminor(minode) == CORE_PUSH_EVENT && --scan_usage == 0){
+		hrtimer_cancel(&scan_timer);
+		printk("fpga_core %u switch events, %u dropped\n", switch_events, switch_dropped);
+	}
+
+	if(--core_usage == 0){
+		hrtimer_cancel(&refresh_timer);
+		printk("fpga_core %u refreshes, %u missed, dot %u fnd %u text %u led %u flushes, %u bytes\n",
+				fb->refresh, fb->missed, fb->flush[FPGA_FB_REGION_DOT], fb->flush[FPGA_FB_REGION_FND],
+				fb->flush[FPGA_FB_REGION_TEXT], fb->flush[FPGA_FB_REGION_LED], fb->bytes);
+		printk("fpga_core %u text lcd cells written, %u in last second\n", fb->text_cells, fb->text_rate);
+	}
+	mutex_unlock(&usage_mutex);
+
+	return 0;
+}
+
+// map shadow page, display updates need no system call after this
+int core_mmap(struct file *mfile, struct vm_area_struct *vma){
+	if((int)mfile->private_data != CORE_FB)
+		return -ENODEV;
+	if(vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start > PAGE_SIZE)
+		return -EINVAL;
+
+	return remap_pfn_range(vma, vma->vm_start, virt_to_phys(fb) >> PAGE_SHIFT,
+			vma->vm_end - vma->vm_start, vma->vm_page_prot);
+}
+
+ssize_t core_write(struct file *mfile, const char *gdata, size_t length, loff_t *off_what){
+	int minor = (int)mfile->private_data;
+	unsigned char buff[sizeof(struct fpga_fb)];
+	unsigned char *region;
+	unsigned long flags;
+	unsigned short value;
+	loff_t off = 0;
+	int size;
+
+	if(minor == CORE_STEP_MOTOR)
+		return motor_submit(mfile, gdata, length);
+	if(minor == CORE_BUZZER)
+		return buzzer_write(gdata, length);
+
+	if(minor == CORE_FND){
+		if(copy_from_user(&value, gdata, sizeof(value)))
+			return -EFAULT;
+		fnd_write(value);
+		return length;
+	}
+
+	if(minor == CORE_LED){
+		if(copy_from_user(buff, gdata, 1))
+			return -EFAULT;
+		outb(buff[0], (unsigned int)led_data);
+		return length;
+	}
+
+	if((region = core_region(minor, &size)) == NULL)
+		return -EINVAL;
+
+	// framebuffer and text lcd are written at offset, others from start
+	if(minor == CORE_FB || minor == CORE_FPGA_TEXT)
+		off = *off_what;
+	if(off >= size)
+		return -ENOSPC;
+	if(length > size - off)
+		length = size - off;
+	if(copy_from_user(buff, gdata, length))
+		return -EFAULT;
+
+	// display writes show at once (changed cells only), page writes wait for refresh
+	spin_lock_irqsave(&core_lock, flags);
+	memcpy(region + off, buff, length);
+	if(minor != CORE_FB)
+		fb_flush();
+	spin_unlock_irqrestore(&core_lock, flags);
+
+	if(minor == CORE_FB)
+		*off_what += length;
+
+	return length;
+}
+
+// whole events only, blocks until one arrives unless O_NONBLOCK
+static ssize_t switch_read(struct file *mfile, char *gdata, size_t length){
+	struct fpga_switch_event ev[SWITCH_FIFO];
+	unsigned long flags;
+	int n, result;
+
+	n = length / sizeof(struct fpga_switch_event);
+	if(n == 0)
+		return -EINVAL;
+	if(n > SWITCH_FIFO)
+		n = SWITCH_FIFO;
+
+	while(kfifo_is_empty(&switch_fifo)){
+		if(mfile->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		result = wait_event_interruptible(switch_wq, !kfifo_is_empty(&switch_fifo));
+		if(result < 0)
+			return result;
+	}
+
+	spin_lock_irqsave(&core_lock, flags);
+	n = kfifo_out(&switch_fifo, ev, n);
+	spin_unlock_irqrestore(&core_lock, flags);
+
+	if(copy_to_user(gdata, ev, n * sizeof(struct fpga_switch_event)))
+		return -EFAULT;
+
+	return n * sizeof(struct fpga_switch_event);
+}
+
+ssize_t core_read(struct file *mfile, char *gdata, size_t length, loff_t *off_what){
+	int minor = (int)mfile->private_data;
+	unsigned char push_sw[PUSH_SWITCH];
+	unsigned char *region;
+	loff_t off = 0;
+	int i, size;
+
+	if(minor == CORE_PUSH_EVENT)
+		return switch_read(mfile, gdata, length);
+	if(minor == CORE_STEP_MOTOR)
+		return motor_read(gdata, length);
+
+	if(minor == CORE_PUSH_SWITCH){
+		for(i=0;i<PUSH_SWITCH;i++)
+			push_sw[i] = inw((unsigned int)iom_addr + IOM_PUSH_SWITCH + i * 2) & 0xFF;
+		if(length > PUSH_SWITCH)
+			length = PUSH_SWITCH;
+		if(copy_to_user(gdata, push_sw, length))
+			return -EFAULT;
+		return length;
+	}
+
+	if((region = core_region(minor, &size)) == NULL)
+		return -EINVAL;
+
+	if(minor == CORE_FB)
+		off = *off_what;
+	if(off >= size)
+		return 0;
+	if(length > size - off)
+		length = size - off;
+	if(copy_to_user(gdata, region + off, length))
+		return -EFAULT;
+
+	if(minor == CORE_FB)
+		*off_what += length;
+
+	return length;
+}
+
+// event device is readable while events are queued, others always are
+unsigned int core_poll(struct file *mfile, poll_table *wait){
+	unsigned int mask = 0;
+
+	// motor is readable when every move is done, writable while queue has room
+	if((int)mfile->private_data == CORE_STEP_MOTOR){
+		poll_wait(mfile, &motor_wq, wait);
+		if(motor_count == 0)
+			mask |= POLLIN | POLLRDNORM;
+		if(motor_count < MOTOR_QUEUE)
+			mask |= POLLOUT | POLLWRNORM;
+		return mask;
+	}
+
+	// buzzer is readable when melody ended
+	if((int)mfile->private_data == CORE_BUZZER){
+		poll_wait(mfile, &buzzer_wq, wait);
+		if(buzzer_notes == 0)
+			mask |= POLLIN | POLLRDNORM;
+		return mask | POLLOUT | POLLWRNORM;
+	}
+
+	if((int)mfile->private_data != CORE_PUSH_EVENT)
+		return POLLIN | POLLRDNORM | POLLOUT | POLLWRNORM;
+
+	poll_wait(mfile, &switch_wq, wait);
+	if(!kfifo_is_empty(&switch_fifo))
+		return POLLIN | POLLRDNORM;
+
+	return 0;
+}
+
+// text lcd position, kept by write() (see fpga_text.h)
+loff_t core_llseek(struct file *mfile, loff_t offset, int whence){
+	int size;
+
+	if(core_region((int)mfile->private_data, &size) == NULL)
+		return -ESPIPE;
+
+	if(whence == SEEK_CUR)
+		offset += mfile->f_pos;
+	else if(whence == SEEK_END)
+		offset += size;
+	else if(whence != SEEK_SET)
+		return -EINVAL;
+	if(offset < 0 || offset > size)
+		return -EINVAL;
+
+	mfile->f_pos = offset;
+	return offset;
+}
+
+// text lcd line update and cell counters
+long core_ioctl(struct file *mfile, unsigned int cmd, unsigned long arg){
+	struct fpga_text_line line;
+	struct fpga_text_stat stat;
+	unsigned long flags;
+
+	if((int)mfile->private_data == CORE_BUZZER)
+		return buzzer_ioctl(cmd);
+	if((int)mfile->private_data != CORE_FPGA_TEXT)
+		return -ENOTTY;
+
+	switch(cmd){
+		case FPGA_TEXT_LINE:
+			if(copy_from_user(&line, (void *)arg, sizeof(line)))
+				return -EFAULT;
+			if(line.line < 0 || line.line >= FPGA_TEXT_LINES)
+				return -EINVAL;
+
+			spin_lock_irqsave(&core_lock, flags);
+			memcpy(fb->text + line.line * FPGA_TEXT_COLS, line.text, FPGA_TEXT_COLS);
+			fb_flush();
+			spin_unlock_irqrestore(&core_lock, flags);
+			return 0;
+
+		case FPGA_TEXT_STAT:
+			stat.cells = fb->text_cells;
+			stat.rate = fb->text_rate;
+			if(copy_to_user((void *)arg, &stat, sizeof(stat)))
+				return -EFAULT;
+			return 0;
+	}
+
+	return -ENOTTY;
+}
+
+// every node is created for udev, applications can open them
+static char *core_devnode(struct device *dev, mode_t *mode){
+	if(mode != NULL)
+		*mode = 0666;
+
+	return NULL;
+}
+
+// unmap gpio windows, any of them may be missing after failed init
+static void gpio_unmap(void){
+	if(fnd_data != NULL)	iounmap(fnd_data);
+	if(fnd_data2 != NULL)	iounmap(fnd_data2);
+	if(fnd_ctrl != NULL)	iounmap(fnd_ctrl);
+	if(fnd_ctrl2 != NULL)	iounmap(fnd_ctrl2);
+	if(led_data != NULL)	iounmap(led_data);
+	if(led_ctrl != NULL)	iounmap(led_ctrl);
+}
+
+int __init core_init(void){
+	ktime_t start = ktime_get();
+	unsigned int get_ctrl_io;
+	int i, result;
+
+	// page shared with userspace, reserved so it can be remapped
+	fb = (struct fpga_fb *)get_zeroed_page(GFP_KERNEL);
+	if(fb == NULL)
+		return -ENOMEM;
+	SetPageReserved(virt_to_page(fb));
+
+	/* GPIO fnd and led */
+	fnd_data = ioremap(FND_GPL2DAT, 0x01);
+	fnd_data2 = ioremap(FND_GPE3DAT, 0x01);
+	fnd_ctrl = ioremap(FND_GPL2CON, 0x04);
+	fnd_ctrl2 = ioremap(FND_GPE3CON, 0x04);
+	led_data = ioremap(LED_GPBDAT, 0x01);
+	led_ctrl = ioremap(LED_GPBCON, 0x04);
+	if(fnd_data == NULL || fnd_data2 == NULL || fnd_ctrl == NULL || fnd_ctrl2 == NULL
+			|| led_data == NULL || led_ctrl == NULL){
+		printk("GPIO ioremap failed!\n");
+		result = -ENOMEM;
+		goto unmap_gpio;
+	}
+	outl(0x11111111, (unsigned int)fnd_ctrl);
+	outl(0x10010110, (unsigned int)fnd_ctrl2);
+	outb(0xFF, (unsigned int)fnd_data);
+
+	// set 4 upper byte of GPB pin register
+	get_ctrl_io = inl((unsigned int)led_ctrl);
+	get_ctrl_io |= (0x11110000);
+	outl(get_ctrl_io, (unsigned int)led_ctrl);
+	outb(0xF0, (unsigned int)led_data);
+
+	/* FPGA window, mapped once for every fpga device */
+	iom_addr = ioremap(IOM_BASE_ADDRESS, IOM_SIZE);
+	if(iom_addr == NULL){
+		printk("FPGA ioremap failed!\n");
+		result = -ENOMEM;
+		goto unmap_gpio;
+	}
+	outb(UON, (unsigned int)iom_addr + IOM_DEMO);
+
+	// devices start cleared, shadow is known to differ once
+	memset(fb->text, ' ', FPGA_FB_TEXT);
+	memset(&shown, 0xFF, sizeof(shown));
+
+	hrtimer_init(&refresh_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	refresh_timer.function = fb_refresh;
+	hrtimer_init(&scan_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	scan_timer.function = switch_scan;
+	hrtimer_init(&motor_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	motor_timer.function = motor_tick;
+	hrtimer_init(&buzzer_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	buzzer_timer.function = buzzer_tick;
+	INIT_KFIFO(switch_fifo);
+
+	// one major for all, minor per sub device
+	result = alloc_chrdev_region(&core_dev, 0, CORE_DEVICES, DEV_NAME);
+	if(result < 0){	// error handler for failture
+		printk(KERN_WARNING"Can't get any major!\n");
+		goto unmap_iom;
+	}
+	cdev_init(&core_cdev, &core_fops);
+	core_cdev.owner = THIS_MODULE;
+	if((result = cdev_add(&core_cdev, core_dev, CORE_DEVICES)) < 0)
+		goto unregister;
+
+	// udev creates /dev nodes from these, no node is usable without them
+	core_class = class_create(THIS_MODULE, DEV_NAME);
+	if(IS_ERR(core_class)){
+		printk("FPGA class create : failed!\n");
+		result = PTR_ERR(core_class);
+		goto del_cdev;
+	}
+	core_class->devnode = core_devnode;
+	for(i=0;i<CORE_DEVICES;i++){
+		struct device *dev = device_create(core_class, NULL, MKDEV(MAJOR(core_dev), i), NULL, core_name[i]);
+
+		if(IS_ERR(dev)){
+			printk("%s device create : failed!\n", core_name[i]);
+			result = PTR_ERR(dev);
+			goto destroy_devices;
+		}
+	}
+
+	printk("init module, /dev/%s major : %d, ready in %lldus\n", DEV_NAME, MAJOR(core_dev),
+			ktime_to_us(ktime_sub(ktime_get(), start)));
+	return 0;
+
+	// undo in reverse order of init
+destroy_devices:
+	while(--i >= 0)
+		device_destroy(core_class, MKDEV(MAJOR(core_dev), i));
+	class_destroy(core_class);
+del_cdev:
+	cdev_del(&core_cdev);
+unregister:
+	unregister_chrdev_region(core_dev, CORE_DEVICES);
+unmap_iom:
+	iounmap(iom_addr);
+unmap_gpio:
+	gpio_unmap();
+	ClearPageReserved(virt_to_page(fb));
+	free_page((unsigned long)fb);
+	return result;
+}
+
+void __exit core_exit(void){
+	int i;
+
+	hrtimer_cancel(&refresh_timer);
+	hrtimer_cancel(&scan_timer);
+	hrtimer_cancel(&motor_timer);
+	outw(0, (unsigned int)iom_addr + IOM_MOTOR_ACTION);
+	hrtimer_cancel(&buzzer_timer);
+	outw(0, (unsigned int)iom_addr + IOM_BUZZER);
+
+	for(i=0;i<CORE_DEVICES;i++)
+		device_destroy(core_class, MKDEV(MAJOR(core_dev), i));
+	class_destroy(core_class);
+	cdev_del(&core_cdev);
+	unregister_chrdev_region(core_dev, CORE_DEVICES);
+
+	/* GPIO free (set to default) */
+	outb(0xFF, (unsigned int)fnd_data);
+	outb(0xF0, (unsigned int)led_data);
+	gpio_unmap();
+
+	/* FPGA free */
+	iounmap(iom_addr);
+
+	ClearPageReserved(virt_to_page(fb));
+	free_page((unsigned long)fb);
+
+	printk("fpga_core module removed.\n");
+}
+
+module_init(core_init);
+module_exit(core_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Lee, Jun-Ho");
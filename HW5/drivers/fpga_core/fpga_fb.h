@@ -0,0 +1,39 @@
+/* Shadow framebuffer of FPGA peripherals (/dev/fpga_fb)
+   userspace maps one page and writes plain memory,
+   fpga_fb module copies changed bytes to devices on every refresh */
+
+#ifndef __FPGA_FB__
+#define __FPGA_FB__
+
+#define FPGA_FB_DOT 10		// rows of dot matrix (bit 6 is left)
+#define FPGA_FB_FND 4		// fnd digits (0 ~ 9, ascii digits also work)
+#define FPGA_FB_TEXT 32		// text lcd characters (two lines)
+
+// regions of page, also index of flush counters
+enum fpga_fb_region{
+	FPGA_FB_REGION_DOT,
+	FPGA_FB_REGION_FND,
+	FPGA_FB_REGION_TEXT,
+	FPGA_FB_REGION_LED,
+	FPGA_FB_REGIONS
+};
+
+// start of mapped page
+struct fpga_fb{
+	// written by userspace
+	unsigned char dot[FPGA_FB_DOT];
+	unsigned char fnd[FPGA_FB_FND];
+	unsigned char text[FPGA_FB_TEXT];
+	unsigned char led;		// fpga led D1 ~ D8 (bit 7 is D1)
+	unsigned char pad;
+
+	// written by driver
+	unsigned int refresh;		// refresh ticks
+	unsigned int missed;		// ticks overrun (refresh took too long)
+	unsigned int flush[FPGA_FB_REGIONS];	// refreshes region was dirty
+	unsigned int bytes;		// bytes written to devices
+	unsigned int text_cells;	// text lcd cells written
+	unsigned int text_rate;		// text lcd cells in last full second
+};
+
+#endif
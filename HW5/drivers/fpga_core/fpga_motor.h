@@ -0,0 +1,24 @@
+/* Step motor of fpga_core (/dev/fpga_step_motor)
+   write() of whole moves queues them and returns at once,
+   read() gives fpga_motor_status, poll reports POLLIN when every move is done,
+   3 byte write (action, direction, speed) of old driver still works
+   and cancels queued moves */
+
+#ifndef __FPGA_MOTOR__
+#define __FPGA_MOTOR__
+
+struct fpga_motor_move{
+	unsigned int dir;		// 0 or 1
+	unsigned int steps;
+	unsigned int speed;		// cruise speed (steps per second)
+	unsigned int accel;		// acceleration and deceleration (steps per second^2)
+};
+
+struct fpga_motor_status{
+	unsigned int submitted;		// moves queued since load
+	unsigned int done;		// moves finished since load
+	unsigned int queued;		// moves waiting or running
+	unsigned int step;		// step of running move
+};
+
+#endif
@@ -0,0 +1,30 @@
+/* Text lcd of fpga_core (/dev/fpga_text_lcd)
+   write() / pwrite() put text at file position (lseek, 0 ~ 31),
+   position is not advanced so writers of whole screen keep working.
+   only cells that differ from what is shown are written to lcd */
+
+#ifndef __FPGA_TEXT__
+#define __FPGA_TEXT__
+
+#include <linux/ioctl.h>
+
+#define FPGA_TEXT_LINES 2
+#define FPGA_TEXT_COLS 16
+
+// one line of lcd
+struct fpga_text_line{
+	int line;			// 0 upper, 1 lower
+	char text[FPGA_TEXT_COLS];
+};
+
+// cells written to lcd
+struct fpga_text_stat{
+	unsigned int cells;		// since module load
+	unsigned int rate;		// in last full second
+};
+
+#define FPGA_TEXT_MAGIC 'T'
+#define FPGA_TEXT_LINE _IOW(FPGA_TEXT_MAGIC, 0, struct fpga_text_line)
+#define FPGA_TEXT_STAT _IOR(FPGA_TEXT_MAGIC, 1, struct fpga_text_stat)
+
+#endif
@@ -0,0 +1,11 @@
+# fpga_core replaces the seven drivers of insdev.sh (do not load both)
+# nodes of every sub device are created by udev / ueventd under one major
+insmod fpga_core.ko
+
+# boards without hotplug daemon
+[ -c /dev/fpga_push_switch ] || mdev -s
+
+chmod 666 /dev/fnd_driver /dev/led_driver /dev/fpga_fnd /dev/fpga_led
+chmod 666 /dev/fpga_dot /dev/fpga_text_lcd /dev/fpga_push_switch /dev/fpga_fb
+chmod 666 /dev/fpga_push_event /dev/fpga_step_motor /dev/fpga_buzzer
+chmod 666 /dev/alarm
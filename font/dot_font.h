@@ -0,0 +1,70 @@
+/* Dot matrix font, generated by dotfont from dot_font.txt
+   do not edit, change the source and run make in font */
+
+#ifndef __DOT_FONT__
+#define __DOT_FONT__
+
+#define DOT_FONT_ROWS 10
+#define DOT_FONT_GLYPHS 28
+
+// codes of glyphs without character
+#define DOT_FROWN 0x01
+#define DOT_FIGURE0 0x10
+#define DOT_FIGURE1 0x11
+#define DOT_FIGURE2 0x12
+#define DOT_FIGURE3 0x13
+#define DOT_FIGURE4 0x14
+#define DOT_FIGURE5 0x15
+#define DOT_FIGURE6 0x16
+#define DOT_FIGURE7 0x17
+#define DOT_FIGURE8 0x18
+#define DOT_FIGURE9 0x19
+#define DOT_FULL 0x7f
+
+static const unsigned char dot_font[DOT_FONT_GLYPHS][DOT_FONT_ROWS] = {
+	{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+	{0x00,0x77,0x22,0x00,0x08,0x08,0x00,0x1c,0x22,0x41},
+	{0x7f,0x7f,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60},
+	{0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x60,0x60},
+	{0x03,0x03,0x03,0x03,0x7f,0x7f,0x03,0x03,0x7f,0x7f},
+	{0x7f,0x7f,0x60,0x60,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x03,0x03,0x7f,0x7f,0x03,0x03,0x7f,0x7f},
+	{0x7f,0x7f,0x63,0x63,0x7f,0x7f,0x60,0x60,0x7f,0x7f},
+	{0x7f,0x7f,0x03,0x03,0x7f,0x7f,0x63,0x63,0x7f,0x7f},
+	{0x3e,0x7f,0x63,0x63,0x7f,0x3f,0x03,0x03,0x03,0x03},
+	{0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x00,0x00,0x0c,0x0c},
+	{0x3e,0x7f,0x63,0x73,0x73,0x6f,0x67,0x63,0x7f,0x3e},
+	{0x0c,0x1c,0x1c,0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x1e},
+	{0x7e,0x7f,0x03,0x03,0x3f,0x7e,0x60,0x60,0x7f,0x7f},
+	{0x7e,0x7f,0x03,0x03,0x7f,0x7f,0x03,0x03,0x7f,0x7e},
+	{0x66,0x66,0x66,0x66,0x66,0x66,0x7f,0x7f,0x06,0x06},
+	{0x7f,0x7f,0x60,0x60,0x7e,0x7f,0x03,0x03,0x7f,0x7e},
+	{0x60,0x60,0x60,0x60,0x7e,0x7f,0x63,0x63,0x7f,0x3e},
+	{0x7f,0x7f,0x63,0x63,0x03,0x03,0x03,0x03,0x03,0x03},
+	{0x3e,0x7f,0x63,0x63,0x7f,0x7f,0x63,0x63,0x7f,0x3e},
+	{0x3e,0x7f,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63},
+	{0x63,0x63,0x63,0x63,0x7f,0x7f,0x63,0x63,0x63,0x63},
+	{0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x7f},
+	{0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x63,0x63,0x63},
+	{0x7e,0x7f,0x63,0x63,0x7f,0x7e,0x60,0x60,0x60,0x60},
+	{0x7f,0x7f,0x1c,0x1c,0x1c,0x1c,0x1c,0x1c,0x1c,0x1c},
+	{0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f,0x7f},
+};
+
+// glyph of each ASCII code
+static const unsigned char dot_font_index[128] = {
+	0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,2,3,4,5,6,7,8,9,10,0,0,0,0,0,0,
+	0,11,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	12,13,14,15,16,17,18,19,20,10,0,0,0,0,0,0,
+	0,21,0,0,0,6,0,0,22,0,0,0,23,24,0,0,
+	25,0,0,0,26,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,27
+};
+
+// 10 bytes of character c, points into font (nothing is copied)
+#define dot_glyph(c) (dot_font[dot_font_index[(unsigned char)(c) & 0x7f]])
+
+#endif
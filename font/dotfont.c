@@ -0,0 +1,237 @@
+/* Dot matrix font compiler (runs on build host)
+   dotfont source... dot_font.h
+
+   sources are read in order, later glyphs replace earlier ones
+	*.bdf	  BDF bitmap font, ASCII encodings clipped to 7x10
+	others	  text font :
+		  glyph '<char>'		printable character
+		  glyph <code> <name>		code 0x00 ~ 0x7f, name gives DOT_<NAME>
+		  10 rows of 7 columns ('#' on, '.' off), then "end"
+
+   output is one constant atlas (identical glyphs stored once) and
+   an ASCII index into it, so a glyph is a single lookup without copy */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define DOT_ROWS 10
+#define DOT_COLS 7
+#define DOT_CODES 128
+#define NAME_LEN 32
+#define LINE_BUFF 256
+
+struct glyph{
+	int defined;
+	char name[NAME_LEN];		// macro name of control code glyph
+	unsigned char row[DOT_ROWS];
+};
+
+static struct glyph glyphs[DOT_CODES];
+static const char *path;
+static int line_no;
+
+static void fail(const char *msg, const char *arg){
+	fprintf(stderr, "%s:%d: %s %s\n", path, line_no, msg, arg ? arg : "");
+	exit(1);
+}
+
+// glyph '<char>' or glyph <code> <name>
+static int parse_code(const char *line, char *name){
+	char code[LINE_BUFF];
+	long c;
+
+	name[0] = '\0';
+	if(sscanf(line, "glyph '%c'", code) == 1)
+		return (unsigned char)code[0];
+
+	if(sscanf(line, "glyph %255s %31s", code, name) != 2)
+		fail("bad glyph", line);
+	c = strtol(code, NULL, 0);
+	if(c < 0 || c >= DOT_CODES)
+		fail("code out of range", code);
+
+	return c;
+}
+
+static void read_text(FILE *fp){
+	char line[LINE_BUFF], name[NAME_LEN];
+	struct glyph *g;
+	int r, c;
+
+	while(fgets(line, sizeof(line), fp) != NULL){
+		line_no++;
+		if(strncmp(line, "glyph", 5) != 0)
+			continue;
+
+		g = &glyphs[parse_code(line, name)];
+		g->defined = 1;
+		strcpy(g->name, name);
+
+		// leftmost column is bit 6
+		for(r=0;r<DOT_ROWS;r++){
+			if(fgets(line, sizeof(line), fp) == NULL)
+				fail("glyph too short", NULL);
+			line_no++;
+			if(strlen(line) < DOT_COLS)
+				fail("row too short", line);
+
+			g->row[r] = 0;
+			for(c=0;c<DOT_COLS;c++)
+				if(line[c] == '#')
+					g->row[r] |= 1 << (DOT_COLS - 1 - c);
+		}
+
+		if(fgets(line, sizeof(line), fp) == NULL || strncmp(line, "end", 3) != 0)
+			fail("glyph without end", NULL);
+		line_no++;
+	}
+}
+
+// BDF : ENCODING, BBX w h x y, BITMAP rows of hex (msb is left), ENDCHAR
+static void read_bdf(FILE *fp){
+	char line[LINE_BUFF];
+	struct glyph *g = NULL;
+	unsigned long bits;
+	int ascent = DOT_ROWS - 2, code = -1, w = 0, h = 0, x = 0, y = 0;
+	int bitmap = 0, r = 0, top = 0, c, shift;
+
+	while(fgets(line, sizeof(line), fp) != NULL){
+		line_no++;
+
+		if(sscanf(line, "FONT_ASCENT %d", &ascent) == 1)
+			continue;
+		if(sscanf(line, "ENCODING %d", &code) == 1)
+			continue;
+		if(sscanf(line, "BBX %d %d %d %d", &w, &h, &x, &y) == 4)
+			continue;
+
+		if(strncmp(line, "BITMAP", 6) == 0){
+			bitmap = 1;
+			r = 0;
+			top = ascent - h - y;	// cell row of first bitmap row
+			g = NULL;
+			if(code >= 0 && code < DOT_CODES){
+				g = &glyphs[code];
+				g->defined = 1;
+				g->name[0] = '\0';
+				memset(g->row, 0, DOT_ROWS);
+			}
+			continue;
+		}
+
+		if(strncmp(line, "ENDCHAR", 7) == 0){
+			bitmap = 0;
+			code = -1;
+			continue;
+		}
+
+		if(!bitmap || g == NULL)
+			continue;
+
+		// row is padded to whole bytes, place columns from x offset
+		bits = strtoul(line, NULL, 16);
+		shift = ((w + 7) / 8) * 8;
+		if(top + r >= 0 && top + r < DOT_ROWS)
+			for(c=0;c<w;c++)
+				if((bits >> (shift - 1 - c)) & 1 && x + c >= 0 && x + c < DOT_COLS)
+					g->row[top + r] |= 1 << (DOT_COLS - 1 - x - c);
+		r++;
+	}
+}
+
+static void upper(char *dst, const char *src){
+	while(*src){
+		*dst++ = toupper((unsigned char)*src);
+		src++;
+	}
+	*dst = '\0';
+}
+
+int main(int argc, char *argv[]){
+	unsigned char atlas[DOT_CODES + 1][DOT_ROWS], index[DOT_CODES];
+	char name[NAME_LEN];
+	const char *ext;
+	FILE *in, *out;
+	int i, k, r, count = 0;
+
+	if(argc < 3){
+		printf("usage: %s source... dot_font.h\n", argv[0]);
+		return 1;
+	}
+
+	for(i=1;i<argc-1;i++){
+		path = argv[i];
+		line_no = 0;
+		if((in = fopen(path, "r")) == NULL){
+			perror(path);
+			return 1;
+		}
+		ext = strrchr(path, '.');
+		if(ext != NULL && strcmp(ext, ".bdf") == 0)
+			read_bdf(in);
+		else
+			read_text(in);
+		fclose(in);
+	}
+
+	// blank is first, characters without glyph point to it
+	memset(atlas[count++], 0, DOT_ROWS);
+	for(i=0;i<DOT_CODES;i++){
+		index[i] = 0;
+		if(!glyphs[i].defined)
+			continue;
+
+		for(k=0;k<count;k++)
+			if(memcmp(atlas[k], glyphs[i].row, DOT_ROWS) == 0)
+				break;
+		if(k == count)
+			memcpy(atlas[count++], glyphs[i].row, DOT_ROWS);
+		index[i] = k;
+	}
+
+	if((out = fopen(argv[argc-1], "w")) == NULL){
+		perror(argv[argc-1]);
+		return 1;
+	}
+
+	fprintf(out, "/* Dot matrix font, generated by dotfont from");
+	for(i=1;i<argc-1;i++)
+		fprintf(out, " %s", argv[i]);
+	fprintf(out, "\n   do not edit, change the source and run make in font */\n\n");
+	fprintf(out, "#ifndef __DOT_FONT__\n#define __DOT_FONT__\n\n");
+	fprintf(out, "#define DOT_FONT_ROWS %d\n", DOT_ROWS);
+	fprintf(out, "#define DOT_FONT_GLYPHS %d\n\n", count);
+
+	fprintf(out, "// codes of glyphs without character\n");
+	for(i=0;i<DOT_CODES;i++)
+		if(glyphs[i].defined && glyphs[i].name[0] != '\0'){
+			upper(name, glyphs[i].name);
+			fprintf(out, "#define DOT_%s 0x%02x\n", name, i);
+		}
+	fprintf(out, "\n");
+
+	fprintf(out, "static const unsigned char dot_font[DOT_FONT_GLYPHS][DOT_FONT_ROWS] = {\n");
+	for(k=0;k<count;k++){
+		fprintf(out, "\t{");
+		for(r=0;r<DOT_ROWS;r++)
+			fprintf(out, "0x%02x%s", atlas[k][r], r < DOT_ROWS - 1 ? "," : "");
+		fprintf(out, "},\n");
+	}
+	fprintf(out, "};\n\n");
+
+	fprintf(out, "// glyph of each ASCII code\n");
+	fprintf(out, "static const unsigned char dot_font_index[%d] = {", DOT_CODES);
+	for(i=0;i<DOT_CODES;i++)
+		fprintf(out, "%s%d%s", i % 16 ? "" : "\n\t", index[i], i < DOT_CODES - 1 ? "," : "\n");
+	fprintf(out, "};\n\n");
+
+	fprintf(out, "// 10 bytes of character c, points into font (nothing is copied)\n");
+	fprintf(out, "#define dot_glyph(c) (dot_font[dot_font_index[(unsigned char)(c) & 0x7f]])\n\n");
+	fprintf(out, "#endif\n");
+	fclose(out);
+
+	printf("%d glyphs in %d bytes\n", count, count * DOT_ROWS);
+	return 0;
+}
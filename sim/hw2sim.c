@@ -0,0 +1,169 @@
+/* Assignment #2 driver on host : hw2sim [-b runs] [-d duty] [time num option]
+   runs dev_driver.c on virtual time, checks registers after every timer tick
+   against a model of the sequence, -b repeats it unchecked and reports cost */
+
+#include <time.h>
+#include "sim.h"
+#include "../HW2/module/dev_driver.c"
+
+#define TEXT_ADDR IOM_FPGA_TEXT_LCD_ADDRESS
+#define LCD_SIZE 32
+
+static int failed;
+static unsigned long expiries;	// every timer and hrtimer run
+
+static void check(int ok, int tick, const char *what){
+	if(ok)
+		return;
+	printf("tick %d : %s\n", tick, what);
+	failed++;
+}
+
+// 4 byte stream of time, num and option, same as sys_returncall
+static long encode(int time, int num, const char *option){
+	int i;
+
+	for(i=0;i<3;i++)
+		if(option[i] != '0')
+			break;
+
+	return (('1' + i) << 24) | (option[i] << 16) | ((time & 0xff) << 8) | (num & 0xff);
+}
+
+// text lcd model, line moves one cell and bounces at both ends
+static void scroll(char *line, int *right){
+	if(*right){
+		memmove(line + 1, line, 15);
+		line[0] = ' ';
+		if(line[15] != ' ')
+			*right = 0;
+	} else{
+		memmove(line, line + 1, 15);
+		line[15] = ' ';
+		if(line[0] != ' ')
+			*right = 1;
+	}
+}
+
+static int run(int time, int num, const char *option, int checked){
+	static const unsigned char sel[4] = {0x02, 0x04, 0x10, 0x80};
+	char id[17] = "20091648        ", name[17] = "Lee Jun Ho      ";
+	char fnd[12];	// any int, like fpga_fnd_write
+	struct file file = {O_WRONLY, NULL};
+	long stream = encode(time, num, option);
+	int id_right = 1, name_right = 1;
+	int tick = 0, position, value, i;
+	s64 last = 0;
+	void *ran;
+
+	sim_reset();
+	text_valid = 0;
+	dev_init();
+	dev_open(NULL, &file);
+	dev_write(&file, &stream, 4, NULL);
+
+	position = (stream >> 24) - '1';
+	value = (stream >> 16) & 0xff;
+
+	while((ran = sim_step()) != NULL){
+		expiries++;
+		if(ran != &mytimer.timer)
+			continue;
+		tick++;
+		if(!checked)
+			continue;
+
+		// countdown on fpga fnd, interval of time x 100ms
+		sprintf(fnd, "%4d", num - tick + 1);
+		for(i=0;i<4;i++)
+			check(inb(IOM_FND_ADDRESS + i) == fnd[i], tick, "fpga fnd count");
+		if(tick > 1)
+			check(sim_now - last == (s64)(time * HZ / 10) * (NSEC_PER_SEC / HZ), tick, "tick interval");
+		last = sim_now;
+
+		if(tick > num)
+			break;
+
+		// figure, fnd digit and led of current position and value
+		for(i=0;i<DOT_FONT_ROWS;i++)
+			check(inb(IOM_FPGA_DOT_ADDRESS + i) == dot_glyph(DOT_FIGURE0 + value - '0')[i], tick, "dot figure");
+		check(inb(FND_GPE3DAT) == sel[position], tick, "fnd digit select");
+		check(inb(LED_GPBDAT) == (0xF0 & ~(0x10 << position)), tick, "led position");
+		check(inb(IOM_LED_ADDRESS) == (0x80 >> (value - '1')), tick, "fpga led value");
+
+		// id and name scroll every tick
+		for(i=0;i<16;i++){
+			check(inb(TEXT_ADDR + i) == (unsigned char)id[i], tick, "text id");
+			check(inb(TEXT_ADDR + 16 + i) == (unsigned char)name[i], tick, "text name");
+		}
+		scroll(id, &id_right);
+		scroll(name, &name_right);
+
+		// value 1 ~ 8, then next position
+		if(++value > '8'){
+			value = '1';
+			position = (position + 1) % 4;
+		}
+	}
+
+	// every device is off after the last count
+	if(checked){
+		check(tick == num + 1, tick, "number of ticks");
+		check(inb(FND_GPE3DAT) == 0, tick, "fnd off");
+		check(inb(LED_GPBDAT) == 0xFF, tick, "led off");
+		check(inb(IOM_LED_ADDRESS) == 0, tick, "fpga led off");
+		for(i=0;i<LCD_SIZE;i++)
+			check(inb(TEXT_ADDR + i) == 0, tick, "text clear");
+	}
+
+	dev_release(NULL, &file);
+	dev_exit();
+	return tick;
+}
+
+int main(int argc, char *argv[]){
+	struct timespec start, end;
+	unsigned long writes;
+	long long ns;
+	int runs = 0, ticks = 0, i = 1;
+	int time = 1, num = 20;
+	const char *option = "0040";
+
+	for(;i<argc && argv[i][0] == '-';i+=2){
+		if(i + 1 >= argc)
+			break;
+		if(strcmp(argv[i], "-b") == 0)
+			runs = atoi(argv[i+1]);
+		else if(strcmp(argv[i], "-d") == 0)
+			fnd_duty = atoi(argv[i+1]);
+	}
+	if(argc - i == 3){
+		time = atoi(argv[i]);
+		num = atoi(argv[i+1]);
+		option = argv[i+2];
+	}
+	if(time < 1 || time > 100 || num < 0 || num > 100 || strlen(option) < 4 || strspn(option, "012345678") < 4){
+		printf("usage: %s [-b runs] [-d duty] [time(1-100) num(0-100) option(0001-8000)]\n", argv[0]);
+		return 1;
+	}
+
+	run(time, num, option, 1);
+	printf("dev_driver %d %d %s : %s, %d failed checks, %.1fs virtual\n",
+			time, num, option, failed ? "FAIL" : "ok", failed, sim_now / 1e9);
+
+	if(runs > 0){
+		sim_quiet = 1;
+		expiries = 0;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i=0,writes=0;i<runs;i++){
+			ticks += run(time, num, option, 0);
+			writes += sim_writes;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		ns = (end.tv_sec - start.tv_sec) * 1000000000LL + end.tv_nsec - start.tv_nsec;
+		printf("%d runs, %d ticks (%lu timer expiries), %lldns per tick, %.1f mmio writes per tick\n",
+				runs, ticks, expiries, ticks ? ns / ticks : 0, ticks ? (double)writes / ticks : 0);
+	}
+
+	return failed != 0;
+}
@@ -0,0 +1,164 @@
+/* Assignment #2 driver with threads as cpus : hw2smp [-s seconds] [-r readers] [-o openers]
+   built with -DSIM_SMP, locks of sim.h are real and the timer runs on its own thread,
+   while readers take dev_read snapshots, openers fight over dev_open and
+   a writer restarts the count with dev_write, in the middle of a tick if it can */
+
+#include <pthread.h>
+#include <unistd.h>
+#include "sim.h"
+#include "../HW2/module/dev_driver.c"
+
+#define THREADS 16
+#define NUM 100		// count of every restart
+#define OPTION "0001"	// last position, first value, wraps position early
+
+static int stop;		// READ_ONCE, threads poll it
+static long stream;
+static int failed;
+static unsigned long ticks, restarts, reads, opens;
+static int holders;	// openers inside dev_open .. dev_release
+
+static void check(int ok, const char *what){
+	if(ok)
+		return;
+	if(__sync_fetch_and_add(&failed, 1) < 10)
+		printf("%s\n", what);
+}
+
+// data shown after a count of ticks, value 1 ~ 8 then next position
+static unsigned short model(int count){
+	int position = (stream >> 24) & 0xff, value = (stream >> 16) & 0xff;
+
+	if(count > NUM)
+		count = NUM;	// last tick keeps its data
+	while(count-- > 0)
+		if(++value > '8'){
+			value = '1';
+			if(++position > '4')
+				position = '1';
+		}
+	return (position << 8) | value;
+}
+
+// give the cpu away between register writes of a tick, so even one
+// cpu runs readers and writer in the middle of kernel_timer_blink
+static void preempt(unsigned long addr, unsigned int value){
+	static unsigned int writes;
+
+	if(++writes % 7 == 0)
+		cpu_relax();
+}
+
+static void *timer_cpu(void *arg){
+	void *ran;
+
+	while(!READ_ONCE(stop)){
+		ran = sim_step();
+		if(ran == &mytimer.timer)
+			ticks++;
+		else if(ran == NULL)
+			cpu_relax();	// count is over, wait for a restart
+	}
+	return NULL;
+}
+
+// restart at random points, del_timer_sync may meet the tick running
+static void *writer(void *arg){
+	unsigned int seed = 1;
+	int spin;
+
+	while(!READ_ONCE(stop)){
+		dev_write(NULL, &stream, 4, NULL);
+		restarts++;
+		for(spin=rand_r(&seed)%20000;spin>0 && !READ_ONCE(stop);spin--)
+			if(spin % 1000 == 0)
+				cpu_relax();
+	}
+	return NULL;
+}
+
+// every snapshot is a count and the data of that same count
+static void *reader(void *arg){
+	unsigned long n = 0;
+	int snapshot[2];
+
+	while(!READ_ONCE(stop)){
+		if(dev_read(NULL, (char *)snapshot, sizeof(snapshot), NULL) != sizeof(snapshot)){
+			check(0, "dev_read size");
+			continue;
+		}
+		if(snapshot[0] < 0 || snapshot[0] > NUM)
+			check(0, "dev_read steps out of range");
+		else if((unsigned short)snapshot[1] != model(NUM - snapshot[0]))
+			check(0, "dev_read data of another tick");
+		if(++n % 64 == 0)
+			cpu_relax();
+	}
+	__sync_fetch_and_add(&reads, n);
+	return NULL;
+}
+
+// one user at a time
+static void *opener(void *arg){
+	unsigned long n = 0;
+	struct file file = {O_WRONLY, NULL};
+
+	while(!READ_ONCE(stop)){
+		if(dev_open(NULL, &file) != 0){
+			cpu_relax();
+			continue;
+		}
+		check(__sync_add_and_fetch(&holders, 1) == 1, "dev_open let two users in");
+		cpu_relax();
+		__sync_sub_and_fetch(&holders, 1);
+		dev_release(NULL, &file);
+		n++;
+	}
+	__sync_fetch_and_add(&opens, n);
+	return NULL;
+}
+
+int main(int argc, char *argv[]){
+	pthread_t threads[THREADS];
+	int seconds = 1, readers = 3, openers = 2, count = 0, i;
+
+	for(i=1;i+1<argc && argv[i][0] == '-';i+=2){
+		if(strcmp(argv[i], "-s") == 0)
+			seconds = atoi(argv[i+1]);
+		else if(strcmp(argv[i], "-r") == 0)
+			readers = atoi(argv[i+1]);
+		else if(strcmp(argv[i], "-o") == 0)
+			openers = atoi(argv[i+1]);
+	}
+	if(i != argc || seconds < 1 || readers < 1 || openers < 0 || readers + openers + 2 > THREADS){
+		printf("usage: %s [-s seconds] [-r readers] [-o openers], %d threads at most\n", argv[0], THREADS - 2);
+		return 1;
+	}
+
+	sim_reset();
+	sim_quiet = 1;
+	text_valid = 0;
+	dev_init();
+	sim_write_hook = preempt;
+	stream = (('1' + 3) << 24) | (OPTION[3] << 16) | (1 << 8) | NUM;
+
+	pthread_create(&threads[count++], NULL, timer_cpu, NULL);
+	pthread_create(&threads[count++], NULL, writer, NULL);
+	for(i=0;i<readers;i++)
+		pthread_create(&threads[count++], NULL, reader, NULL);
+	for(i=0;i<openers;i++)
+		pthread_create(&threads[count++], NULL, opener, NULL);
+
+	sleep(seconds);
+	WRITE_ONCE(stop, 1);
+	for(i=0;i<count;i++)
+		pthread_join(threads[i], NULL);
+	dev_exit();
+
+	printf("dev_driver smp %d readers %d openers %ds on %ld cpus : %s, %d failed checks\n",
+			readers, openers, seconds, sysconf(_SC_NPROCESSORS_ONLN), failed ? "FAIL" : "ok", failed);
+	printf("%lu ticks, %lu restarts, %lu reads (%lu seqlock retries), %lu opens\n",
+			ticks, restarts, reads, sim_retries, opens);
+
+	return failed != 0;
+}
@@ -0,0 +1,162 @@
+/* Assignment #3 driver on host : hw3sim [-r refresh_hz] [-t seconds]
+   runs stopwatch.c on virtual time with scripted switch presses,
+   checks fnd digits and mapped state page at fixed points,
+   then reports host cost of each fnd refresh slot */
+
+#include <time.h>
+#include "sim.h"
+#include "../HW3/module/stopwatch.c"
+
+#define SEC(s) ((s64)((s) * 1e9))
+#define SW_START S5PV310_GPX2(0)
+#define SW_PAUSE S5PV310_GPX2(1)
+#define SW_RESET S5PV310_GPX2(2)
+#define SW_QUIT S5PV310_GPX2(4)
+
+struct expect{
+	double at;		// virtual time (s)
+	const char *fnd;	// mmss on fnd
+	double elapsed;		// seconds on state page
+	int laps;
+};
+
+// press schedule, 100ms per press
+static const struct{
+	double at;
+	int gpio;
+	double hold;
+} presses[] = {
+	{0.5, SW_START, 0.1},
+	{2.75, SW_PAUSE, 0.1},
+	{3.0, SW_START, 0.1},
+	{3.5, SW_START, 0.1},		// already running, no effect
+	{70.0, SW_RESET, 0.1},
+	{71.0, SW_START, 0.1},
+	{80.0, SW_QUIT, 1.0},		// too short to quit
+};
+
+static const struct expect expects[] = {
+	{0.4, "0000", 0, 0},
+	{2.0, "0001", 1.5, 0},
+	{10.0, "0009", 9.25, 1},
+	{65.3, "0104", 64.55, 1},
+	{70.5, "0000", 0, 0},
+	{130.5, "0059", 59.5, 0},
+	{3671.5, "0000", 3600.5, 0},	// fnd wraps after 59:59
+};
+
+static unsigned char fnd_seen[0x100];	// segments shown at each digit select
+static int failed;
+
+static void fnd_hook(unsigned long addr, unsigned int value){
+	if(addr == FND_GPE3DAT && value != 0)
+		fnd_seen[value] = sim_in(FND_GPL2DAT);
+}
+
+static int fnd_digit(unsigned char sel){
+	int n;
+
+	for(n=0;n<10;n++)
+		if((unsigned char)convertChar(n) == fnd_seen[sel])
+			return n;
+	return -1;
+}
+
+static void press(void *arg){
+	sim_gpio((int)(long)arg, 0);
+}
+
+static void release(void *arg){
+	sim_gpio((int)(long)arg, 1);
+}
+
+static void verify(void *arg){
+	const struct expect *e = arg;
+	unsigned int laps;
+	s64 elapsed;
+	char fnd[12];	// unknown digit prints as -1
+
+	// one full scan passed since last change, every digit is fresh
+	sprintf(fnd, "%d%d%d%d", fnd_digit(0x02), fnd_digit(0x04), fnd_digit(0x10), fnd_digit(0x80));
+	elapsed = stopwatch_elapsed(state, sim_now, &laps);
+
+	if(strcmp(fnd, e->fnd) != 0 || elapsed != SEC(e->elapsed) || laps != e->laps){
+		printf("%.2fs : fnd %s (%s), %lldns (%lld), %u laps (%d)\n", e->at, fnd, e->fnd,
+				(long long)elapsed, (long long)SEC(e->elapsed), laps, e->laps);
+		failed++;
+	}
+}
+
+int main(int argc, char *argv[]){
+	struct file owner = {O_WRONLY, NULL}, reader = {O_RDONLY, NULL}, second = {O_WRONLY, NULL};
+	struct vm_area_struct vma = {0, PAGE_SIZE, 0, 0, 0};
+	struct timespec start, end;
+	double seconds = 3700;
+	long long ns;
+	int i;
+
+	for(i=1;i+1<argc;i+=2){
+		if(strcmp(argv[i], "-r") == 0)
+			refresh_hz = atoi(argv[i+1]);
+		else if(strcmp(argv[i], "-t") == 0)
+			seconds = atof(argv[i+1]);
+	}
+	if(i != argc || seconds < 1){
+		printf("usage: %s [-r refresh_hz] [-t seconds]\n", argv[0]);
+		return 1;
+	}
+
+	sim_reset();
+	stopwatch_init();
+	sim_write_hook = fnd_hook;
+
+	// owner, readers next to it, no second owner
+	if(stopwatch_open(NULL, &owner) != 0 || stopwatch_open(NULL, &reader) != 0
+			|| stopwatch_open(NULL, &second) != -EBUSY){
+		printf("open : owner / reader accounting broken\n");
+		failed++;
+	}
+	vma.vm_flags = VM_WRITE;
+	if(stopwatch_mmap(&reader, &vma) != -EPERM){
+		printf("mmap : writable mapping allowed\n");
+		failed++;
+	}
+
+	for(i=0;i<sizeof(presses)/sizeof(presses[0]);i++){
+		sim_at(SEC(presses[i].at), press, (void *)(long)presses[i].gpio);
+		sim_at(SEC(presses[i].at + presses[i].hold), release, (void *)(long)presses[i].gpio);
+	}
+	for(i=0;i<sizeof(expects)/sizeof(expects[0]);i++)
+		if(expects[i].at < seconds)
+			sim_at(SEC(expects[i].at), verify, (void *)&expects[i]);
+
+	// hold quit switch 3 seconds at the end
+	sim_at(SEC(seconds), press, (void *)(long)SW_QUIT);
+
+	sim_quiet = 1;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	stopwatch_write(&owner, NULL, 0, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	sim_quiet = 0;
+
+	if(sim_now != SEC(seconds + 3)){
+		printf("quit at %.3fs, expected %.3fs\n", sim_now / 1e9, seconds + 3);
+		failed++;
+	}
+	if(refresh_missed != 0){
+		printf("%u refresh deadlines missed on virtual time\n", refresh_missed);
+		failed++;
+	}
+
+	ns = (end.tv_sec - start.tv_sec) * 1000000000LL + end.tv_nsec - start.tv_nsec;
+	printf("stopwatch %dHz : %s, %d failed checks, %.1fs virtual in %.3fs\n",
+			refresh_hz, failed ? "FAIL" : "ok", failed, sim_now / 1e9, ns / 1e9);
+	printf("%u refresh slots, %lluns per slot, %.2f mmio writes per slot\n",
+			refresh_count, refresh_count ? ns / refresh_count : 0, refresh_count ? (double)sim_writes / refresh_count : 0);
+
+	stopwatch_release(NULL, &reader);
+	stopwatch_release(NULL, &owner);
+	stopwatch_exit();
+
+	return failed != 0;
+}
@@ -0,0 +1,240 @@
+/* Assignment #3 driver with threads as cpus : hw3smp [-s seconds] [-r readers] [-o openers]
+   built with -DSIM_SMP like hw2smp, the owner runs stopwatch_write (virtual time)
+   while switches raise interrupts on their own threads, readers compute elapsed
+   time from the state page, openers fight over stopwatch_open and SW6 is tapped
+   or held until the quit timer ends the write, then the owner opens again */
+
+#include <pthread.h>
+#include <unistd.h>
+#include "sim.h"
+#include "../HW3/module/stopwatch.c"
+
+#define THREADS 16
+#define SEC(s) ((s64)((s) * 1e9))
+#define JIFFY_NS (NSEC_PER_SEC / HZ)
+#define SW_START S5PV310_GPX2(0)
+#define SW_PAUSE S5PV310_GPX2(1)
+#define SW_RESET S5PV310_GPX2(2)
+#define SW_QUIT S5PV310_GPX2(4)
+#define HOLD_TRIES 2000		// yields before SW6 is let go without quit
+
+static int stop;		// READ_ONCE, threads poll it
+static int done;		// owner finished, SW6 may rest
+static int failed;
+static unsigned long quits, presses, reads, opens;
+static int holders;	// owners inside stopwatch_open .. stopwatch_release
+static s64 quit_press;	// virtual time of last SW6 press
+static s64 quit_release;	// and of its release, S64_MAX while held
+static unsigned long resets_begun, resets_done;	// SW_RESET or owner open clears state
+
+static void check(int ok, const char *what){
+	if(ok)
+		return;
+	if(__sync_fetch_and_add(&failed, 1) < 10)
+		printf("%s\n", what);
+}
+
+// give the cpu away between register writes of a refresh slot
+static void preempt(unsigned long addr, unsigned int value){
+	static unsigned int writes;
+
+	if(++writes % 7 == 0)
+		cpu_relax();
+}
+
+static int owner_open(struct file *file){
+	int ret;
+
+	__sync_fetch_and_add(&resets_begun, 1);
+	ret = stopwatch_open(NULL, file);
+	__sync_fetch_and_add(&resets_done, 1);
+	return ret;
+}
+
+static void spin(unsigned int *seed, int most){
+	int n;
+
+	for(n=rand_r(seed)%most;n>0;n--)
+		if(n % 1000 == 0)
+			cpu_relax();
+}
+
+// timer cpu : every write runs until SW6 was held 3 seconds
+static void *owner(void *arg){
+	struct file file = {O_WRONLY, NULL};
+	unsigned int seed = 3;
+	s64 at;
+
+	while(!READ_ONCE(stop)){
+		if(owner_open(&file) != 0){
+			cpu_relax();
+			continue;
+		}
+		check(__sync_add_and_fetch(&holders, 1) == 1, "stopwatch_open let two owners in");
+
+		stopwatch_write(&file, NULL, 0, NULL);
+		at = ktime_get();
+		check(at - READ_ONCE(quit_press) >= SEC(3) - JIFFY_NS, "quit before SW6 held 3 seconds");
+		check(at <= READ_ONCE(quit_release), "quit after SW6 released");
+		quits++;
+
+		__sync_sub_and_fetch(&holders, 1);
+		stopwatch_release(NULL, &file);
+		spin(&seed, 20000);	// openers get the device now and then
+	}
+	WRITE_ONCE(done, 1);
+	return NULL;
+}
+
+// start, pause and reset at random, mostly running
+static void *buttons(void *arg){
+	static const int sw[8] = {SW_START, SW_START, SW_START, SW_START, SW_START, SW_PAUSE, SW_PAUSE, SW_RESET};
+	unsigned int seed = 1;
+	unsigned long n = 0;
+	int gpio;
+
+	while(!READ_ONCE(stop)){
+		gpio = sw[rand_r(&seed) % 8];
+		if(gpio == SW_RESET)
+			__sync_fetch_and_add(&resets_begun, 1);
+		sim_gpio(gpio, 0);
+		if(gpio == SW_RESET)
+			__sync_fetch_and_add(&resets_done, 1);
+		spin(&seed, 2000);
+		sim_gpio(gpio, 1);
+		spin(&seed, 20000);
+		n++;
+	}
+	__sync_fetch_and_add(&presses, n);
+	return NULL;
+}
+
+// yields until quit, done or HOLD_TRIES
+static void hold(void){
+	int tries;
+
+	for(tries=0;tries<HOLD_TRIES && atomic_read(&quit_flag) && !READ_ONCE(done);tries++)
+		cpu_relax();
+}
+
+// taps, rests and holds, a quit is seen by the owner before next press
+static void *quitter(void *arg){
+	unsigned int seed = 2;
+	unsigned long n = 0;
+	int tap;
+
+	while(!READ_ONCE(done)){
+		if(!atomic_read(&quit_flag)){
+			cpu_relax();
+			continue;
+		}
+		WRITE_ONCE(quit_release, INT64_MAX);
+		WRITE_ONCE(quit_press, ktime_get());
+		sim_gpio(SW_QUIT, 0);
+		tap = !READ_ONCE(stop) && rand_r(&seed) % 4 != 0;
+		if(tap)
+			spin(&seed, 20000);
+		else
+			hold();
+		sim_gpio(SW_QUIT, 1);
+		WRITE_ONCE(quit_release, ktime_get());
+		if(tap && rand_r(&seed) % 2 == 0)
+			hold();		// released long enough to quit if tap was not cancelled
+		n++;
+	}
+	__sync_fetch_and_add(&presses, n);
+	return NULL;
+}
+
+// a page read is one state, never more than time passed and never
+// back from last read unless a reset overlapped, now is late by after - now
+static void *reader(void *arg){
+	unsigned long n = 0, done, last_done = 0;
+	unsigned int laps;
+	s64 now, after, elapsed, last = 0;
+
+	while(!READ_ONCE(stop)){
+		done = READ_ONCE(resets_done);
+		now = ktime_get();
+		elapsed = stopwatch_elapsed(state, now, &laps);
+		after = ktime_get();
+		check(elapsed <= now, "state page counts more than time passed");
+		check(elapsed >= now - after, "state page counts below zero");
+		if(n > 0 && READ_ONCE(resets_begun) == last_done)
+			check(elapsed >= last - (after - now), "state page went back without reset");
+		last = elapsed;
+		last_done = done;
+		if(++n % 64 == 0)
+			cpu_relax();
+	}
+	__sync_fetch_and_add(&reads, n);
+	return NULL;
+}
+
+// one owner at a time, readers do not count
+static void *opener(void *arg){
+	unsigned long n = 0;
+	struct file file = {O_WRONLY, NULL}, page = {O_RDONLY, NULL};
+
+	while(!READ_ONCE(stop)){
+		check(stopwatch_open(NULL, &page) == 0, "stopwatch_open refused a reader");
+		stopwatch_release(NULL, &page);
+		if(owner_open(&file) != 0){
+			cpu_relax();
+			continue;
+		}
+		check(__sync_add_and_fetch(&holders, 1) == 1, "stopwatch_open let two owners in");
+		cpu_relax();
+		__sync_sub_and_fetch(&holders, 1);
+		stopwatch_release(NULL, &file);
+		cpu_relax();	// owner gets the device back now and then
+		n++;
+	}
+	__sync_fetch_and_add(&opens, n);
+	return NULL;
+}
+
+int main(int argc, char *argv[]){
+	pthread_t threads[THREADS];
+	int seconds = 1, readers = 3, openers = 2, count = 0, i;
+
+	for(i=1;i+1<argc && argv[i][0] == '-';i+=2){
+		if(strcmp(argv[i], "-s") == 0)
+			seconds = atoi(argv[i+1]);
+		else if(strcmp(argv[i], "-r") == 0)
+			readers = atoi(argv[i+1]);
+		else if(strcmp(argv[i], "-o") == 0)
+			openers = atoi(argv[i+1]);
+	}
+	if(i != argc || seconds < 1 || readers < 1 || openers < 0 || readers + openers + 3 > THREADS){
+		printf("usage: %s [-s seconds] [-r readers] [-o openers], %d threads at most\n", argv[0], THREADS - 3);
+		return 1;
+	}
+
+	sim_reset();
+	sim_quiet = 1;
+	stopwatch_init();
+	sim_write_hook = preempt;
+
+	pthread_create(&threads[count++], NULL, owner, NULL);
+	pthread_create(&threads[count++], NULL, buttons, NULL);
+	pthread_create(&threads[count++], NULL, quitter, NULL);
+	for(i=0;i<readers;i++)
+		pthread_create(&threads[count++], NULL, reader, NULL);
+	for(i=0;i<openers;i++)
+		pthread_create(&threads[count++], NULL, opener, NULL);
+
+	sleep(seconds);
+	WRITE_ONCE(stop, 1);
+	for(i=0;i<count;i++)
+		pthread_join(threads[i], NULL);
+	stopwatch_exit();
+
+	check(quits > 0, "SW6 never quit");
+	printf("stopwatch smp %d readers %d openers %ds on %ld cpus : %s, %d failed checks\n",
+			readers, openers, seconds, sysconf(_SC_NPROCESSORS_ONLN), failed ? "FAIL" : "ok", failed);
+	printf("%lu quits, %.1fs virtual, %lu presses, %lu reads, %lu opens\n",
+			quits, sim_now / 1e9, presses, reads, opens);
+
+	return failed != 0;
+}
@@ -0,0 +1,377 @@
+/* Virtual time scheduler and register table behind sim.h */
+
+#include <stdarg.h>
+#include "sim.h"
+
+#define SIM_TIMERS 16
+#define SIM_EVENTS 64
+#define SIM_REGS 1024		// register table (power of 2)
+#define SIM_GPIOS 0x200
+#define JIFFY_NS (NSEC_PER_SEC / HZ)
+
+struct sim_event{
+	s64 at;
+	void (*fn)(void *);
+	void *arg;
+	int pending;
+};
+
+struct sim_reg{
+	unsigned long addr;
+	unsigned int value;
+	int used;
+};
+
+struct sim_irq{
+	void *handler;
+	unsigned long flags;
+	void *dev;
+	int running;	// handler is on a cpu
+};
+
+s64 sim_now;
+int sim_quiet;
+unsigned long sim_writes;
+void (*sim_write_hook)(unsigned long addr, unsigned int value);
+#ifdef SIM_SMP
+unsigned long sim_retries;
+#endif
+
+// timer lists and register table, taken only when threads are cpus (-DSIM_SMP)
+static DEFINE_SPINLOCK(board_lock);
+
+static struct timer_list *timers[SIM_TIMERS];
+static int timer_count;
+static struct hrtimer *hrtimers[SIM_TIMERS];
+static int hrtimer_count;
+static struct sim_event events[SIM_EVENTS];
+static struct sim_reg regs[SIM_REGS];
+static struct sim_irq irqs[SIM_GPIOS];
+static unsigned char gpio_low[SIM_GPIOS];	// switches are pulled up
+
+#ifdef SIM_SMP
+void sim_preempt(void){
+	static unsigned int stores;
+
+	if(__sync_add_and_fetch(&stores, 1) % 7 == 0)
+		cpu_relax();
+}
+#endif
+
+void init_timer(struct timer_list *t){
+	int i;
+
+	t->pending = 0;
+	t->running = 0;
+	for(i=0;i<timer_count;i++)
+		if(timers[i] == t)
+			return;
+	if(timer_count < SIM_TIMERS)
+		timers[timer_count++] = t;
+}
+
+void add_timer(struct timer_list *t){
+	spin_lock(&board_lock);
+	t->pending = 1;
+	spin_unlock(&board_lock);
+}
+
+int mod_timer(struct timer_list *t, unsigned long expires){
+	int was;
+
+	spin_lock(&board_lock);
+	was = t->pending;
+	t->expires = expires;
+	t->pending = 1;
+	spin_unlock(&board_lock);
+	return was;
+}
+
+// waits for a running function, which may have added the timer again
+int del_timer_sync(struct timer_list *t){
+	int was;
+
+	for(;;){
+		spin_lock(&board_lock);
+		if(!t->running)
+			break;
+		spin_unlock(&board_lock);
+		cpu_relax();
+	}
+	was = t->pending;
+	t->pending = 0;
+	spin_unlock(&board_lock);
+	return was;
+}
+
+// expired timers run on next tick, like the timer softirq
+static s64 timer_due(struct timer_list *t){
+	unsigned long now = jiffies;
+
+	return (s64)(t->expires > now ? t->expires : now + 1) * JIFFY_NS;
+}
+
+void hrtimer_init(struct hrtimer *t, int clock, enum hrtimer_mode mode){
+	int i;
+
+	t->pending = 0;
+	t->running = 0;
+	for(i=0;i<hrtimer_count;i++)
+		if(hrtimers[i] == t)
+			return;
+	if(hrtimer_count < SIM_TIMERS)
+		hrtimers[hrtimer_count++] = t;
+}
+
+int hrtimer_start(struct hrtimer *t, ktime_t time, enum hrtimer_mode mode){
+	int was;
+
+	spin_lock(&board_lock);
+	was = t->pending;
+	t->expires = mode == HRTIMER_MODE_REL ? sim_now + time : time;
+	t->pending = 1;
+	spin_unlock(&board_lock);
+	return was;
+}
+
+// waits for a running function like del_timer_sync
+int hrtimer_cancel(struct hrtimer *t){
+	int was;
+
+	for(;;){
+		spin_lock(&board_lock);
+		if(!t->running)
+			break;
+		spin_unlock(&board_lock);
+		cpu_relax();
+	}
+	was = t->pending;
+	t->pending = 0;
+	spin_unlock(&board_lock);
+	return was;
+}
+
+u64 hrtimer_forward(struct hrtimer *t, ktime_t now, ktime_t interval){
+	u64 overrun;
+
+	if(now < t->expires)
+		return 0;
+	if(interval < 1)
+		interval = 1;
+
+	overrun = (now - t->expires) / interval + 1;
+	t->expires += overrun * interval;
+	return overrun;
+}
+
+int sim_printk(const char *fmt, ...){
+	va_list ap;
+	int n;
+
+	if(sim_quiet)
+		return 0;
+	va_start(ap, fmt);
+	n = vprintf(fmt, ap);
+	va_end(ap);
+	return n;
+}
+
+unsigned long get_zeroed_page(int flags){
+	void *page = aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+
+	if(page != NULL)
+		memset(page, 0, PAGE_SIZE);
+	return (unsigned long)page;
+}
+
+static struct sim_reg *sim_reg(unsigned long addr){
+	unsigned int i = (addr * 2654435761u) & (SIM_REGS - 1);
+
+	while(regs[i].used && regs[i].addr != addr)
+		i = (i + 1) & (SIM_REGS - 1);
+	regs[i].used = 1;
+	regs[i].addr = addr;
+	return &regs[i];
+}
+
+void sim_out(unsigned long addr, unsigned int value){
+	spin_lock(&board_lock);
+	sim_reg(addr)->value = value;
+	sim_writes++;
+	spin_unlock(&board_lock);
+	if(sim_write_hook != NULL)
+		sim_write_hook(addr, value);
+}
+
+unsigned int sim_in(unsigned long addr){
+	unsigned int value;
+
+	spin_lock(&board_lock);
+	value = sim_reg(addr)->value;
+	spin_unlock(&board_lock);
+	return value;
+}
+
+int request_irq(unsigned int irq, void *handler, unsigned long flags, const char *name, void *dev){
+	if(irq >= SIM_GPIOS)
+		return -EINVAL;
+	spin_lock(&board_lock);
+	if(irqs[irq].handler != NULL){
+		spin_unlock(&board_lock);
+		return -EBUSY;
+	}
+	irqs[irq].handler = handler;
+	irqs[irq].flags = flags;
+	irqs[irq].dev = dev;
+	spin_unlock(&board_lock);
+	return 0;
+}
+
+// no new call of handler, then waits for one on another cpu (synchronize_irq)
+void free_irq(unsigned int irq, void *dev){
+	if(irq >= SIM_GPIOS)
+		return;
+	spin_lock(&board_lock);
+	irqs[irq].handler = NULL;
+	while(irqs[irq].running){
+		spin_unlock(&board_lock);
+		cpu_relax();
+		spin_lock(&board_lock);
+	}
+	spin_unlock(&board_lock);
+}
+
+int sim_gpio_level(int gpio){
+	int level;
+
+	spin_lock(&board_lock);
+	level = !gpio_low[gpio];
+	spin_unlock(&board_lock);
+	return level;
+}
+
+void sim_gpio(int gpio, int level){
+	irqreturn_t (*handler)(int, void *, struct pt_regs *) = NULL;
+	struct sim_irq *irq = &irqs[gpio];
+	void *dev = NULL;
+	int was;
+
+	spin_lock(&board_lock);
+	was = !gpio_low[gpio];
+	gpio_low[gpio] = !level;
+	if(irq->handler != NULL && was != level
+			&& ((level && (irq->flags & IRQF_TRIGGER_RISING)) || (!level && (irq->flags & IRQF_TRIGGER_FALLING)))){
+		handler = irq->handler;
+		dev = irq->dev;
+		irq->running++;
+	}
+	spin_unlock(&board_lock);
+
+	// handler runs unlocked, it may take timers and write registers
+	if(handler == NULL)
+		return;
+	handler(gpio, dev, NULL);
+	spin_lock(&board_lock);
+	irq->running--;
+	spin_unlock(&board_lock);
+}
+
+void sim_at(s64 at, void (*fn)(void *), void *arg){
+	int i;
+
+	for(i=0;i<SIM_EVENTS;i++)
+		if(!events[i].pending){
+			events[i].at = at;
+			events[i].fn = fn;
+			events[i].arg = arg;
+			events[i].pending = 1;
+			return;
+		}
+	fprintf(stderr, "sim: too many events\n");
+	exit(1);
+}
+
+void *sim_step(void){
+	struct sim_event *ev = NULL;
+	struct timer_list *timer = NULL;
+	struct hrtimer *hrtimer = NULL;
+	enum hrtimer_restart restart;
+	s64 at = 0, due;
+	int i, found = 0;
+
+	spin_lock(&board_lock);
+
+	// earliest of all, events before timers at the same time
+	for(i=0;i<SIM_EVENTS;i++)
+		if(events[i].pending && (!found || events[i].at < at)){
+			ev = &events[i];
+			at = ev->at;
+			found = 1;
+		}
+	for(i=0;i<timer_count;i++){
+		if(!timers[i]->pending)
+			continue;
+		due = timer_due(timers[i]);
+		if(!found || due < at){
+			ev = NULL;
+			timer = timers[i];
+			at = due;
+			found = 1;
+		}
+	}
+	for(i=0;i<hrtimer_count;i++)
+		if(hrtimers[i]->pending && (!found || hrtimers[i]->expires < at)){
+			ev = NULL;
+			timer = NULL;
+			hrtimer = hrtimers[i];
+			at = hrtimer->expires;
+			found = 1;
+		}
+
+	if(!found){
+		spin_unlock(&board_lock);
+		return NULL;
+	}
+	if(at > sim_now)
+		WRITE_ONCE(sim_now, at);
+
+	// function runs unlocked, it may add timers and write registers
+	if(ev != NULL){
+		ev->pending = 0;
+		spin_unlock(&board_lock);
+		ev->fn(ev->arg);
+		return ev;
+	}
+	if(timer != NULL){
+		timer->pending = 0;
+		timer->running = 1;
+		spin_unlock(&board_lock);
+		timer->function(timer->data);
+		spin_lock(&board_lock);
+		timer->running = 0;
+		spin_unlock(&board_lock);
+		return timer;
+	}
+
+	hrtimer->pending = 0;
+	hrtimer->running = 1;
+	spin_unlock(&board_lock);
+	restart = hrtimer->function(hrtimer);
+	spin_lock(&board_lock);
+	if(restart == HRTIMER_RESTART)
+		hrtimer->pending = 1;
+	hrtimer->running = 0;
+	spin_unlock(&board_lock);
+	return hrtimer;
+}
+
+void sim_reset(void){
+	sim_now = 0;
+	sim_writes = 0;
+	sim_write_hook = NULL;
+	timer_count = hrtimer_count = 0;
+	memset(events, 0, sizeof(events));
+	memset(regs, 0, sizeof(regs));
+	memset(irqs, 0, sizeof(irqs));
+	memset(gpio_low, 0, sizeof(gpio_low));
+}
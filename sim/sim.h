@@ -0,0 +1,262 @@
+/* Mock kernel and board for host builds of the drivers (-DSIM)
+   just enough of the 2.6.35 API used by HW2 dev_driver.c and HW3 stopwatch.c,
+   mmio goes to a register table, timers run on virtual time (sim_step) */
+
+#ifndef __SIM__
+#define __SIM__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef int64_t s64;
+typedef uint64_t u64;
+typedef uint32_t u32;
+
+// module boilerplate, every macro leaves a valid declaration for its ';'
+#define __init
+#define __exit
+#define asmlinkage
+#define THIS_MODULE NULL
+#define KERN_WARNING ""
+#define KERN_INFO ""
+#define printk sim_printk
+#define module_init(fn) extern int sim_unused
+#define module_exit(fn) extern int sim_unused
+#define MODULE_LICENSE(x) extern int sim_unused
+#define MODULE_AUTHOR(x) extern int sim_unused
+#define MODULE_PARM_DESC(n, d) extern int sim_unused
+#define module_param(n, t, p) extern int sim_unused
+#define module_param_array(n, t, c, p) extern int sim_unused
+
+#define ERESTARTSYS 512
+
+// time
+#define HZ 100
+#define NSEC_PER_SEC 1000000000L
+#define NSEC_PER_MSEC 1000000L
+#define NSEC_PER_USEC 1000L
+#define USEC_PER_SEC 1000000L
+#define MSEC_PER_SEC 1000L
+
+typedef s64 ktime_t;
+
+extern s64 sim_now;		// virtual time (ns)
+
+#define ktime_set(s, ns) ((s64)(s) * NSEC_PER_SEC + (s64)(ns))
+#define ktime_get() READ_ONCE(sim_now)
+#define ktime_sub(a, b) ((a) - (b))
+#define ktime_add_ns(a, ns) ((a) + (s64)(ns))
+#define ktime_to_ns(a) (a)
+#define ktime_to_us(a) ((a) / 1000)
+#define div_s64(a, b) ((s64)(a) / (b))
+#define jiffies ((unsigned long)(ktime_get() / (NSEC_PER_SEC / HZ)))
+#define get_jiffies_64() ((u64)jiffies)
+
+struct timer_list{
+	unsigned long expires;
+	void (*function)(unsigned long);
+	unsigned long data;
+	int pending;
+	int running;	// function is on a cpu
+};
+
+void init_timer(struct timer_list *);
+void add_timer(struct timer_list *);
+int mod_timer(struct timer_list *, unsigned long);
+int del_timer_sync(struct timer_list *);
+
+enum hrtimer_restart{ HRTIMER_NORESTART, HRTIMER_RESTART };
+enum hrtimer_mode{ HRTIMER_MODE_ABS, HRTIMER_MODE_REL };
+#define CLOCK_MONOTONIC 1
+
+struct hrtimer{
+	ktime_t expires;
+	enum hrtimer_restart (*function)(struct hrtimer *);
+	int pending;
+	int running;
+};
+
+void hrtimer_init(struct hrtimer *, int, enum hrtimer_mode);
+int hrtimer_start(struct hrtimer *, ktime_t, enum hrtimer_mode);
+int hrtimer_cancel(struct hrtimer *);
+u64 hrtimer_forward(struct hrtimer *, ktime_t, ktime_t);
+#define hrtimer_forward_now(t, i) hrtimer_forward(t, ktime_get(), i)
+#define hrtimer_cb_get_time(t) ktime_get()
+#define hrtimer_get_expires(t) ((t)->expires)
+#define hrtimer_active(t) ((t)->pending || (t)->running)
+
+// locking, host run is single threaded, ordering is kept for seqlocks
+// -DSIM_SMP makes them real, every thread of the harness is a cpu (hw2smp, hw3smp)
+#define smp_wmb() __sync_synchronize()
+#define smp_rmb() __sync_synchronize()
+
+// loads and stores racing by design (seqlock sections, flags), ACCESS_ONCE
+// on the board, atomic here so -fsanitize=thread knows them (make tsan)
+#define READ_ONCE(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+#ifdef SIM_SMP
+#include <sched.h>
+
+#define cpu_relax() sched_yield()
+
+// such a store is where another cpu gets in, even when the host has one
+void sim_preempt(void);
+#define WRITE_ONCE(x, v) (__atomic_store_n(&(x), (v), __ATOMIC_RELAXED), sim_preempt())
+
+typedef volatile int spinlock_t;
+#define DEFINE_SPINLOCK(x) spinlock_t x = 0
+#define spin_lock(l) do{ while(__sync_lock_test_and_set(l, 1)) cpu_relax(); }while(0)
+#define spin_unlock(l) __sync_lock_release(l)
+#define spin_lock_irqsave(l, f) do{ (f) = 0; spin_lock(l); }while(0)
+#define spin_unlock_irqrestore(l, f) do{ (void)(f); spin_unlock(l); }while(0)
+
+extern unsigned long sim_retries;	// seqlock reads done again
+
+typedef struct{
+	volatile unsigned int sequence;
+	spinlock_t lock;	// writers
+} seqlock_t;
+#define DEFINE_SEQLOCK(x) seqlock_t x = {0, 0}
+#define write_seqlock(s) do{ spin_lock(&(s)->lock); WRITE_ONCE((s)->sequence, (s)->sequence + 1); smp_wmb(); }while(0)
+#define write_sequnlock(s) do{ smp_wmb(); WRITE_ONCE((s)->sequence, (s)->sequence + 1); spin_unlock(&(s)->lock); }while(0)
+#define read_seqbegin(s) ({ \
+	unsigned int __seq; \
+	while((__seq = READ_ONCE((s)->sequence)) & 1) \
+		cpu_relax(); \
+	smp_rmb(); \
+	__seq; })
+#define read_seqretry(s, seq) (smp_rmb(), READ_ONCE((s)->sequence) != (seq) ? (__sync_fetch_and_add(&sim_retries, 1), 1) : 0)
+#else
+#define cpu_relax() do{}while(0)
+#define WRITE_ONCE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+
+typedef int spinlock_t;
+#define DEFINE_SPINLOCK(x) spinlock_t x = 0
+#define spin_lock(l) ((void)(l))
+#define spin_unlock(l) ((void)(l))
+#define spin_lock_irqsave(l, f) ((void)(l), (f) = 0)
+#define spin_unlock_irqrestore(l, f) ((void)(l), (void)(f))
+
+typedef struct{
+	unsigned int sequence;
+} seqlock_t;
+#define DEFINE_SEQLOCK(x) seqlock_t x = {0}
+#define write_seqlock(s) ((s)->sequence++, smp_wmb())
+#define write_sequnlock(s) (smp_wmb(), (s)->sequence++)
+#define read_seqbegin(s) ((s)->sequence & ~1u)
+#define read_seqretry(s, seq) ((s)->sequence != (seq))
+#endif
+#define write_seqlock_bh(s) write_seqlock(s)
+#define write_sequnlock_bh(s) write_sequnlock(s)
+
+typedef struct{
+	int counter;
+} atomic_t;
+#define ATOMIC_INIT(i) {i}
+#define atomic_read(a) __atomic_load_n(&(a)->counter, __ATOMIC_RELAXED)
+#define atomic_set(a, i) __atomic_store_n(&(a)->counter, (i), __ATOMIC_RELAXED)
+#define atomic_cmpxchg(a, o, n) __sync_val_compare_and_swap(&(a)->counter, o, n)
+
+// wait queue, a sleeper runs virtual time until its condition holds
+typedef struct{
+	int unused;
+} wait_queue_head_t;
+#define DECLARE_WAIT_QUEUE_HEAD(n) wait_queue_head_t n = {0}
+#define wake_up_interruptible(q) ((void)(q))
+#define wait_event_interruptible(q, cond) ({ \
+	int __ret = 0; \
+	while(!(cond)) \
+		if(sim_step() == NULL){ \
+			__ret = -ERESTARTSYS; \
+			break; \
+		} \
+	__ret; })
+
+// memory and user copies
+#define GFP_KERNEL 0
+#define kmalloc(n, f) malloc(n)
+#define kfree(p) free(p)
+#define copy_from_user(to, from, n) (memcpy(to, from, n), 0)
+#define copy_to_user(to, from, n) (memcpy(to, from, n), 0)
+
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1UL << PAGE_SHIFT)
+#define VM_WRITE 0x2
+#define VM_MAYWRITE 0x20
+
+struct vm_area_struct{
+	unsigned long vm_start, vm_end, vm_pgoff, vm_flags;
+	int vm_page_prot;
+};
+
+unsigned long get_zeroed_page(int);
+#define free_page(a) free((void *)(a))
+#define virt_to_page(p) (p)
+#define virt_to_phys(p) ((unsigned long)(p))
+#define SetPageReserved(p) ((void)(p))
+#define ClearPageReserved(p) ((void)(p))
+#define remap_pfn_range(v, a, pfn, n, prot) 0
+
+// character devices
+struct inode;
+struct class;
+struct device;
+struct pt_regs;
+
+struct file{
+	unsigned int f_flags;
+	void *private_data;
+};
+
+struct file_operations{
+	void *owner, *open, *release, *read, *write, *mmap, *poll, *unlocked_ioctl, *llseek;
+};
+
+#define MKDEV(ma, mi) (((ma) << 20) | (mi))
+#define register_chrdev(major, name, fops) ((void)(fops), 0)
+#define unregister_chrdev(major, name) ((void)0)
+#define device_create(c, p, dev, d, name) ((void)(c), (struct device *)1)
+
+// board : mmio register table, gpio levels and their interrupts
+#define ioremap(phys, size) ((void *)(uintptr_t)(phys))
+#define iounmap(p) ((void)(p))
+#define outb(v, a) sim_out(a, (v) & 0xff)
+#define outw(v, a) sim_out(a, (v) & 0xffff)
+#define outl(v, a) sim_out(a, v)
+#define inb(a) (sim_in(a) & 0xff)
+#define inw(a) (sim_in(a) & 0xffff)
+#define inl(a) sim_in(a)
+
+typedef int irqreturn_t;
+#define IRQ_HANDLED 1
+#define IRQF_TRIGGER_RISING 0x1
+#define IRQF_TRIGGER_FALLING 0x2
+#define S5PV310_GPX2(n) (0x100 + (n))
+#define gpio_to_irq(g) (g)
+#define gpio_get_value(g) sim_gpio_level(g)
+
+int request_irq(unsigned int, void *, unsigned long, const char *, void *);
+void free_irq(unsigned int, void *);
+
+// harness side
+int sim_printk(const char *fmt, ...);
+extern int sim_quiet;		// drop printk of driver
+void sim_out(unsigned long addr, unsigned int value);
+unsigned int sim_in(unsigned long addr);
+extern void (*sim_write_hook)(unsigned long addr, unsigned int value);
+extern unsigned long sim_writes;	// mmio writes since start
+
+int sim_gpio_level(int gpio);
+void sim_gpio(int gpio, int level);	// edge raises irq of gpio if requested, free_irq waits for it
+void sim_at(s64 at, void (*fn)(void *), void *arg);
+
+// run earliest pending event or timer, returns what ran (NULL if nothing left)
+void *sim_step(void);
+void sim_reset(void);
+
+#endif